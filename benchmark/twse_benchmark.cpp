@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../include/parser.h"
+#include "../include/feed_generator.h"
+#include "../include/framing.h"
+#include "../include/bcd.h"
+
+// Decoder benchmarks on a synthetic Format 6/17/14/23 stream, reported as JSON.
+//
+// Every in-memory benchmark walks the same pre-generated corpus `repeat`
+// times after one warm-up pass; the median pass is reported together with the
+// best one. The UDP benchmark measures sendto() on loopback to the start of
+// the callback, one datagram in flight at a time.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Corpus {
+    std::vector<uint8_t> data;
+    std::vector<std::pair<size_t, size_t>> datagrams; // (offset, length)
+    std::vector<std::pair<size_t, size_t>> messages;  // (offset, length)
+};
+
+struct Result {
+    std::string name;
+    uint64_t messages = 0;       // Per pass
+    uint64_t bytes = 0;          // Per pass
+    double ns_per_msg = 0;       // Median pass
+    double ns_per_msg_best = 0;
+    LatencySummary latency{};    // Only for the UDP benchmark
+    uint64_t lost = 0;
+    bool has_latency = false;
+};
+
+Corpus build_corpus(const FeedGeneratorOptions& options, size_t datagram_count) {
+    Corpus corpus;
+    FeedGenerator generator(options);
+    uint8_t buffer[65536];
+    for (size_t i = 0; i < datagram_count; ++i) {
+        size_t length = generator.next_datagram(buffer, sizeof(buffer));
+        size_t offset = corpus.data.size();
+        corpus.data.insert(corpus.data.end(), buffer, buffer + length);
+        corpus.datagrams.emplace_back(offset, length);
+
+        // Split on the message_length field, as the generator always writes it correctly
+        size_t position = 0;
+        while (position < length) {
+            size_t message_length = bcd_to_binary((buffer[position + 1] << 8) | buffer[position + 2]);
+            corpus.messages.emplace_back(offset + position, message_length);
+            position += message_length;
+        }
+    }
+    return corpus;
+}
+
+// Run pass() once to warm up, then repeat times, and keep the median and best
+template <typename Pass>
+Result run(const std::string& name, uint64_t messages, uint64_t bytes, size_t repeat, Pass pass) {
+    pass();
+    std::vector<double> timings;
+    for (size_t i = 0; i < repeat; ++i) {
+        auto start = Clock::now();
+        pass();
+        timings.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    std::sort(timings.begin(), timings.end());
+
+    Result result;
+    result.name = name;
+    result.messages = messages;
+    result.bytes = bytes;
+    result.ns_per_msg = timings[timings.size() / 2] / messages;
+    result.ns_per_msg_best = timings.front() / messages;
+    return result;
+}
+
+// Parse every message, or every datagram, of the corpus through Parser::parse_buffer
+Result bench_parse(const std::string& name, const Corpus& corpus, bool per_message, bool decode_bcd,
+                   size_t repeat) {
+    Parser parser;
+    parser.set_decode_bcd(decode_bcd);
+    uint64_t sink = 0;
+    parser.set_packet_callback([&sink](const Packet& packet) { sink += packet.level_count; });
+
+    const auto& units = per_message ? corpus.messages : corpus.datagrams;
+    Result result = run(name, corpus.messages.size(), corpus.data.size(), repeat, [&] {
+        for (const auto& unit : units) {
+            parser.parse_buffer(corpus.data.data() + unit.first, unit.second);
+        }
+    });
+    if (sink == 0) std::cerr << "No packets were delivered in " << name << std::endl;
+    return result;
+}
+
+// Locate every terminal code with the SIMD scan, as the resync path does
+Result bench_framing(const Corpus& corpus, size_t repeat) {
+    uint64_t found = 0;
+    Result result = run("framing", corpus.messages.size(), corpus.data.size(), repeat, [&] {
+        for (const auto& datagram : corpus.datagrams) {
+            const uint8_t* data = corpus.data.data() + datagram.first;
+            size_t position = 0;
+            while (position < datagram.second) {
+                size_t terminal = find_terminal_code(data + position, datagram.second - position);
+                if (terminal == datagram.second - position) break;
+                position += terminal + 2;
+                found++;
+            }
+        }
+    });
+    if (found == 0) std::cerr << "No terminal codes were found" << std::endl;
+    return result;
+}
+
+Result bench_checksum(const Corpus& corpus, size_t repeat) {
+    uint64_t sink = 0;
+    Result result = run("checksum", corpus.messages.size(), corpus.data.size(), repeat, [&] {
+        for (const auto& message : corpus.messages) {
+            // Everything between ESC-CODE and the checksum byte
+            sink += xor_checksum(corpus.data.data() + message.first + 1, message.second - 4);
+        }
+    });
+    if (sink == 0) std::cerr << "Checksum benchmark produced no data" << std::endl;
+    return result;
+}
+
+// Ping-pong over loopback: send one message, wait for its callback, repeat
+Result bench_udp(const Corpus& corpus, int port, size_t samples) {
+    Result result;
+    result.name = "udp_loopback";
+    result.has_latency = true;
+
+    std::atomic<uint64_t> received{0};
+    Parser parser;
+    parser.start_loop(port, [&received](const Packet&) { received.fetch_add(1, std::memory_order_release); });
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // Give the receive thread time to bind, and warm up the path
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    LatencyHistogram histogram;
+    uint64_t expected = 0;
+    size_t warmup = std::min<size_t>(samples / 10, 1000);
+    for (size_t i = 0; i < samples + warmup; ++i) {
+        const auto& message = corpus.messages[i % corpus.messages.size()];
+        auto start = Clock::now();
+        sendto(fd, corpus.data.data() + message.first, message.second, 0,
+               reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+        auto deadline = start + std::chrono::milliseconds(100);
+        bool arrived = true;
+        while (received.load(std::memory_order_acquire) <= expected) {
+            if (Clock::now() > deadline) {
+                arrived = false;
+                break;
+            }
+            // Lets the receive thread run when both share a core
+            std::this_thread::yield();
+        }
+        auto end = Clock::now();
+        expected = received.load(std::memory_order_acquire);
+
+        if (i < warmup) continue;
+        if (!arrived) {
+            result.lost++;
+            continue;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        histogram.record(static_cast<uint64_t>(elapsed.count()));
+        result.bytes += message.second;
+    }
+
+    close(fd);
+    parser.end_loop();
+
+    result.latency = histogram.summary();
+    result.messages = result.latency.count;
+    result.ns_per_msg = static_cast<double>(result.latency.mean);
+    result.ns_per_msg_best = static_cast<double>(result.latency.min);
+    return result;
+}
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+std::string to_json(const std::vector<Result>& results, const FeedGeneratorOptions& options, const Corpus& corpus,
+                    size_t repeat) {
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    char timestamp[32];
+    time_t now = time(nullptr);
+    struct tm tm_buf;
+    gmtime_r(&now, &tm_buf);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm_buf);
+
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    out << "{\n"
+        << "  \"schema_version\": 1,\n"
+        << "  \"timestamp\": \"" << timestamp << "\",\n"
+        << "  \"host\": \"" << json_escape(hostname) << "\",\n"
+        << "  \"cpu\": \"" << json_escape(cpu_model()) << "\",\n"
+        << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"compiler\": \"" << json_escape(__VERSION__) << "\",\n"
+        << "  \"corpus\": {\"seed\": " << options.seed << ", \"symbols\": " << options.symbols
+        << ", \"datagrams\": " << corpus.datagrams.size() << ", \"messages\": " << corpus.messages.size()
+        << ", \"bytes\": " << corpus.data.size() << ", \"repeat\": " << repeat << "},\n"
+        << "  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        double msgs_per_sec = r.ns_per_msg > 0 ? 1e9 / r.ns_per_msg : 0;
+        double mb_per_sec = r.ns_per_msg > 0 ? r.bytes / (r.ns_per_msg * r.messages) * 1e3 : 0;
+        out << "    {\"name\": \"" << r.name << "\", \"messages\": " << r.messages
+            << ", \"ns_per_msg\": " << r.ns_per_msg << ", \"ns_per_msg_best\": " << r.ns_per_msg_best
+            << ", \"msgs_per_sec\": " << msgs_per_sec;
+        if (r.has_latency) {
+            out << ", \"lost\": " << r.lost << ", \"latency_ns\": {\"min\": " << r.latency.min
+                << ", \"p50\": " << r.latency.p50 << ", \"p90\": " << r.latency.p90
+                << ", \"p99\": " << r.latency.p99 << ", \"p999\": " << r.latency.p999
+                << ", \"max\": " << r.latency.max << "}";
+        } else {
+            out << ", \"mb_per_sec\": " << mb_per_sec;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    FeedGeneratorOptions options;
+    size_t datagrams = 100000;
+    size_t repeat = 5;
+    size_t samples = 100000;
+    int port = 15000;
+    bool udp = true;
+    std::string output;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "-datagrams" && i + 1 < argc) {
+            datagrams = std::stoul(argv[++i]);
+        } else if (arg == "-symbols" && i + 1 < argc) {
+            options.symbols = std::stoul(argv[++i]);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "-repeat" && i + 1 < argc) {
+            repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "-udp-samples" && i + 1 < argc) {
+            samples = std::stoul(argv[++i]);
+        } else if (arg == "-port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "-no-udp") {
+            udp = false;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [-output FILE] [-datagrams N] [-symbols N] [-seed N] [-repeat N]"
+                      << " [-udp-samples N] [-port PORT] [-no-udp]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (datagrams == 0) datagrams = 1;
+    Corpus corpus = build_corpus(options, datagrams);
+
+    std::vector<Result> results;
+    results.push_back(bench_parse("parse_message", corpus, true, false, repeat));
+    results.push_back(bench_parse("parse_datagram", corpus, false, false, repeat));
+    results.push_back(bench_parse("parse_datagram_bcd", corpus, false, true, repeat));
+    results.push_back(bench_framing(corpus, repeat));
+    results.push_back(bench_checksum(corpus, repeat));
+    if (udp && samples > 0) {
+        results.push_back(bench_udp(corpus, port, samples));
+    }
+
+    std::string json = to_json(results, options, corpus, repeat);
+    if (output.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(output);
+        file << json;
+        if (!file) {
+            std::cerr << "Failed to write " << output << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -113,20 +113,16 @@ void handle_packet(const Packet& packet, const std::string& mode, const std::str
     
     Logger::getInstance().log(ss.str());
 
-    if (packet.prices.empty()) {
+    if (packet.level_count == 0) {
         Logger::getInstance().log("Error: No prices found in packet!");
         return;
     }
 
     // Print prices and quantities
-    // for (size_t i = 0; i < packet.prices.size(); ++i) {
+    // for (size_t i = 0; i < packet.level_count; ++i) {
     //     std::stringstream price_ss;
     //     price_ss << "Price " << i + 1 << ": " << packet.prices[i] << ", Quantity: ";
-    //     if (i < packet.quantities.size()) {
-    //         price_ss << packet.quantities[i];
-    //     } else {
-    //         price_ss << "N/A";
-    //     }
+    //     price_ss << packet.quantities[i];
     //     Logger::getInstance().log(price_ss.str());
     // }
 
@@ -194,6 +190,11 @@ int main(int argc, char* argv[]) {
         parser.set_allowed_format_codes(format_codes);
     }
 
+    // Drop quotes of other stocks before they are decoded
+    if (!logger_stock.empty()) {
+        parser.set_symbol_filter({logger_stock});
+    }
+
     // Start the parser with the callback function
     parser.start_loop(port, [mode, logger_stock](const Packet& p) { handle_packet(p, mode, logger_stock); });
 
@@ -0,0 +1,103 @@
+#ifndef ARBITER_H
+#define ARBITER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Range of transmission numbers that never arrived on any line
+struct GapEvent {
+    uint8_t feed_id;
+    uint8_t format_code;
+    uint32_t first_missing; // Inclusive, decoded from BCD
+    uint32_t last_missing;  // Inclusive, decoded from BCD
+};
+
+using GapCallback = std::function<void(const GapEvent&)>;
+
+// Per-feed arbitration counters
+struct ArbitrationStats {
+    uint64_t delivered;    // Messages passed on (first arrival of each sequence number)
+    uint64_t duplicates;   // Copies dropped because the sequence number was already delivered
+    uint64_t gaps;         // Gap events raised
+    uint64_t missing;      // Sequence numbers in those gaps
+    uint64_t out_of_order; // Late arrivals delivered behind the newest sequence number
+    uint64_t resets;       // Streams restarted by a large backward jump
+};
+
+// A/B line arbitration on transmission_number.
+//
+// Every (feed_id, format_code) pair is an independent sequence stream. The first
+// copy of each sequence number is delivered, whichever line it came from, and
+// later copies are dropped. A sliding window of recently seen sequence numbers
+// lets a message that one line skipped still be delivered if the other line
+// supplies it later, so a number is only reported as a gap once the window has
+// moved past it unfilled.
+//
+// A number more than WINDOW behind the newest one cannot be a late copy from
+// the other line: it is a new session, a feed reset or a wrap of the counter,
+// so the stream starts over from it. A restart that goes back by less than
+// WINDOW cannot be told apart from a lagging line and is dropped as duplicates
+// until it passes the old newest number.
+//
+// accept() must only be called from the receive thread; stats() may be called
+// from any thread.
+class LineArbiter {
+public:
+    LineArbiter();
+
+    // Returns true if the message should be delivered; may invoke the gap callback
+    bool accept(uint8_t feed_id, uint8_t format_code, uint32_t transmission_number);
+
+    void set_gap_callback(const GapCallback& callback);
+
+    ArbitrationStats stats(uint8_t feed_id) const;
+
+    // Forget all sequence state and counters
+    void reset();
+
+    // Number of sequence numbers behind the newest one that can still be recovered
+    static constexpr uint32_t WINDOW = 4096;
+
+private:
+    struct Stream {
+        bool started = false;
+        uint32_t first_sequence = 0;
+        uint32_t next_expected = 0;
+        std::array<uint64_t, WINDOW / 64> seen{};
+        bool gap_open = false;    // Expired numbers from gap_start on never arrived
+        uint32_t gap_start = 0;
+
+        bool test(uint32_t sequence) const;
+        void set(uint32_t sequence);
+        void clear(uint32_t sequence);
+
+        // Oldest number still tracked for gaps: the window, but not before the start
+        uint32_t window_start() const;
+        void seed(uint32_t sequence);
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> duplicates{0};
+        std::atomic<uint64_t> gaps{0};
+        std::atomic<uint64_t> missing{0};
+        std::atomic<uint64_t> out_of_order{0};
+        std::atomic<uint64_t> resets{0};
+    };
+
+    // Streams are allocated on first use, indexed by (feed_id << 8) | format_code
+    // Move numbers in [from, to) out of the window; a run of them that never arrived
+    // is reported as one gap when the number after it expires
+    void expire(Stream& stream, uint8_t feed_id, uint8_t format_code, uint32_t from, uint32_t to);
+    void report_gap(uint8_t feed_id, uint8_t format_code, uint32_t first_missing, uint32_t last_missing);
+
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::array<Counters, 256> counters;
+    GapCallback gap_callback;
+};
+
+#endif // ARBITER_H
@@ -0,0 +1,108 @@
+#ifndef BAR_ENGINE_H
+#define BAR_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "spsc_ring.h"
+
+struct Packet;
+
+// One completed OHLCV bar of a symbol. Prices are integers in 0.0001 units and
+// times are microseconds since midnight (exchange match_time), whether or not
+// the parser decodes BCD.
+struct Bar {
+    char stock_code[6];
+    uint8_t format_code;       // 0x06 for the board-lot book (Format 6 and 17), 0x23 for odd lots
+    uint8_t feed_id;
+    uint32_t interval_ms;
+    uint64_t start_time;       // Bar covers [start_time, start_time + interval)
+    uint64_t last_trade_time;
+    uint32_t open;
+    uint32_t high;
+    uint32_t low;
+    uint32_t close;
+    uint32_t vwap;             // turnover / volume
+    uint32_t trade_count;
+    uint64_t volume;           // Traded in the bar: lots for the board-lot book, shares for odd lots
+    uint64_t turnover;         // Sum of price x volume, in 0.0001 units
+    uint64_t cumulative_volume; // Session volume at the last trade of the bar
+};
+
+using BarCallback = std::function<void(const Bar&)>;
+
+// Incremental per-symbol OHLCV / VWAP aggregation over one or more intervals.
+//
+// Symbols live in a flat open-addressing table keyed by the packed stock code
+// (odd-lot books apart from board-lot books, as in SnapshotStore); the open
+// bars of every interval sit next to each other in one flat array indexed by
+// symbol slot. Traded volume is the increase of cumulative_volume, so a
+// dropped message shifts volume to the next trade rather than losing it;
+// the first trade of a symbol uses its trade quantity. Trial-match updates
+// (status_note bit 7) are ignored.
+//
+// Bars are aligned to the interval and closed once the feed's match_time
+// passes their end, for every symbol at once, and then handed to the callback
+// or queued for poll(). Only trades open bars; an interval without trades
+// produces no bar. Single writer: update() and flush() run on the thread that
+// parses.
+class BarEngine {
+public:
+    // intervals_ms: bar lengths, e.g. {1000, 60000}; capacity is rounded up to a power of two
+    BarEngine(const std::vector<uint32_t>& intervals_ms, size_t capacity, size_t queue_capacity = 65536);
+
+    // Completed bars go to the callback (on the parsing thread) instead of the queue
+    void set_callback(const BarCallback& callback);
+
+    // Writer side: apply a decoded Format 6/17/23 packet. Returns false if the symbol table is full.
+    bool update(const Packet& packet);
+
+    // Close every open bar, e.g. at the end of the session
+    void flush();
+
+    // Consumer side: copy up to max_bars queued bars into out
+    size_t poll(Bar* out, size_t max_bars);
+
+    // Bars lost because the queue was full
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    const std::vector<uint32_t>& intervals() const { return interval_ms; }
+
+private:
+    struct Symbol {
+        uint64_t key = 0; // Packed stock code and book, 0 when empty
+        uint64_t cumulative_volume = 0;
+        bool has_volume = false;
+    };
+
+    struct OpenBar {
+        Bar bar;
+        bool active = false;
+        bool listed = false; // In open_slots
+    };
+
+    OpenBar& open_bar(size_t slot, size_t interval) { return bars[slot * interval_ms.size() + interval]; }
+
+    // Close bars of an interval that ended before bucket
+    void close_before(size_t interval, uint64_t bucket);
+    void emit(const Bar& bar);
+
+    std::vector<uint32_t> interval_ms;
+    std::unique_ptr<Symbol[]> symbols;
+    std::unique_ptr<OpenBar[]> bars;
+    size_t mask;
+
+    // Symbol slots with an open bar, per interval, so closing never scans the whole table
+    std::vector<std::vector<uint32_t>> open_slots;
+    std::vector<uint64_t> current_bucket;
+    uint64_t latest_time = 0;
+
+    BarCallback callback;
+    SpscRing<Bar> queue;
+    std::atomic<uint64_t> dropped{0};
+};
+
+#endif // BAR_ENGINE_H
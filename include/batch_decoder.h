@@ -0,0 +1,79 @@
+#ifndef BATCH_DECODER_H
+#define BATCH_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "capture.h"
+
+struct Packet;
+
+// Reader for classic libpcap files (microsecond or nanosecond timestamps, either
+// byte order). Ethernet (with VLAN tags), Linux cooked (SLL / SLL2), BSD
+// loopback and raw IP link types are supported. Each UDP/IPv4 payload is
+// returned as a CaptureRecord; everything else is skipped. pcapng is not
+// supported.
+class PcapReader {
+public:
+    PcapReader() = default;
+    ~PcapReader();
+
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Map UDP destination ports to feed ids; without any mapping every UDP datagram is feed 0
+    void add_port_feed(uint16_t port, uint8_t feed_id);
+
+    // Next UDP payload, or false at end of file
+    bool next(CaptureRecord& record);
+
+private:
+    bool extract_udp(const uint8_t* frame, size_t length, CaptureRecord& record) const;
+
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    size_t offset = 0;
+    bool swapped = false;
+    bool nanosecond = false;
+    uint32_t link_type = 0;
+    std::vector<std::pair<uint16_t, uint8_t>> port_feeds;
+};
+
+struct BatchDecodeOptions {
+    size_t threads = 0;                                   // 0: one per hardware thread
+    size_t chunk_datagrams = 16384;                       // Datagrams per thread per round; bounds memory use
+    std::vector<uint8_t> format_codes;                    // As for Parser::set_allowed_format_codes; empty = all
+    std::vector<std::pair<uint16_t, uint8_t>> port_feeds; // pcap only: UDP port -> feed_id
+    bool decode_bcd = false;
+    bool deduplicate = true;                              // Drop A/B copies, only where lines are known (see below)
+};
+
+// Receives decoded packets in order, a batch at a time
+using BatchDecodeSink = std::function<void(const Packet* packets, size_t count)>;
+
+// Decode a pcap or capture file in parallel and stream the packets to sink.
+//
+// The file is read in rounds of threads * chunk_datagrams datagrams. Each
+// thread decodes its chunk and sorts it; the sorted chunks are merged and
+// handed to sink before the next round starts, so memory use does not grow
+// with the file. Within a round, packets are ordered by stream, i.e. (feed_id,
+// business_type, format_code), then by transmission_number. A jump back by
+// more than LineArbiter::WINDOW starts a new session, which sorts after the
+// one before it. Rounds follow the file.
+//
+// deduplicate drops repeats of a transmission_number within a stream, as
+// LineArbiter does live. It only applies when lines are mapped explicitly: to
+// capture files, which record feed ids, and to pcap files with port_feeds.
+// Without a mapping every pcap datagram is feed 0 and nothing is dropped.
+bool decode_capture_file(const std::string& path, const BatchDecodeOptions& options, const BatchDecodeSink& sink);
+
+// Same, collecting every packet into out; for files that fit in memory
+bool decode_capture_file(const std::string& path, const BatchDecodeOptions& options, std::vector<Packet>& out);
+
+#endif // BATCH_DECODER_H
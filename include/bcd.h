@@ -0,0 +1,23 @@
+#ifndef BCD_H
+#define BCD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Convert a right-aligned PACK BCD value (two digits per byte, most significant
+// nibble first, up to 16 digits) to its binary value, e.g. 0x00871234 -> 871234.
+//
+// SWAR: every byte is first turned into its two-digit value, then neighbouring
+// lanes are merged pairwise (x100, x10000, x100000000) in three more steps.
+inline uint64_t bcd_to_binary(uint64_t bcd) {
+    bcd -= 6 * ((bcd >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+    bcd = (bcd & 0x00FF00FF00FF00FFULL) + ((bcd >> 8) & 0x00FF00FF00FF00FFULL) * 100;
+    bcd = (bcd & 0x0000FFFF0000FFFFULL) + ((bcd >> 16) & 0x0000FFFF0000FFFFULL) * 10000;
+    return (bcd & 0xFFFFFFFFULL) + (bcd >> 32) * 100000000ULL;
+}
+
+// Decode n values in place with the same arithmetic as bcd_to_binary.
+// Uses AVX2 or SSSE3 when the CPU supports them, and the SWAR version otherwise.
+void bcd_to_binary_batch(uint64_t* values, size_t n);
+
+#endif // BCD_H
@@ -0,0 +1,117 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Capture file layout (little endian, append-only):
+//
+//   CaptureFileHeader
+//   { CaptureRecordHeader, payload[length] } ...
+//
+// Each record is one raw UDP datagram exactly as received.
+struct CaptureFileHeader {
+    char magic[8];       // "TWSECAP" + NUL
+    uint32_t version;    // CAPTURE_VERSION
+    uint32_t reserved;
+    uint64_t created_ns; // Wall clock when the file was created
+};
+
+struct CaptureRecordHeader {
+    uint64_t timestamp_ns; // Kernel receive time if enabled, otherwise wall clock at receive
+    uint16_t length;       // Payload bytes
+    uint8_t feed_id;
+    uint8_t line_id;
+    uint32_t reserved;
+};
+
+constexpr uint32_t CAPTURE_VERSION = 1;
+
+// Appends datagrams to a capture file without doing I/O on the calling thread.
+//
+// The receive thread copies each datagram into one of two large buffers; a
+// background thread writes a buffer out once it is full. The receive thread
+// never blocks: if both buffers are full the datagram is dropped and counted.
+class CaptureWriter {
+public:
+    explicit CaptureWriter(size_t buffer_size = 4 << 20);
+    ~CaptureWriter();
+
+    bool open(const std::string& path);
+
+    // Flush buffered records and stop the writer thread
+    void close();
+
+    // Called from the receive thread only
+    void append(uint64_t timestamp_ns, uint8_t feed_id, uint8_t line_id, const uint8_t* data, size_t length);
+
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+    bool is_open() const { return fd >= 0; }
+
+private:
+    void writer_loop();
+    void write_buffer(std::vector<uint8_t>& buffer, size_t used);
+
+    int fd = -1;
+    size_t buffer_size;
+
+    // Double buffer: the receive thread fills buffers[active] while the writer drains the other
+    std::vector<uint8_t> buffers[2];
+    size_t used[2] = {0, 0};
+    int active = 0;
+    std::atomic<bool> full[2];
+
+    std::thread writer_thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::atomic<uint64_t> dropped{0};
+};
+
+// One datagram read back from a capture file; data points into the mapping
+struct CaptureRecord {
+    uint64_t timestamp_ns;
+    uint8_t feed_id;
+    uint8_t line_id;
+    const uint8_t* data;
+    size_t length;
+};
+
+// Sequential reader over a memory-mapped capture file
+class CaptureReader {
+public:
+    CaptureReader() = default;
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Next record, or false at end of file (a truncated last record is ignored)
+    bool next(CaptureRecord& record);
+
+    // Start again from the first record
+    void rewind();
+
+    // Raw access to the whole mapping, e.g. for splitting the file across threads
+    const uint8_t* data() const { return mapping; }
+    size_t size() const { return mapping_size; }
+
+    // Parse the record starting at offset; returns the offset of the following record, or 0 at the end
+    static size_t read_record(const uint8_t* data, size_t size, size_t offset, CaptureRecord& record);
+
+private:
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    size_t offset = 0;
+};
+
+#endif // CAPTURE_H
@@ -0,0 +1,163 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Packet;
+
+// Columns of a tick batch, one row per Format 6/17/23 message
+enum TickColumnId : size_t {
+    TICK_RECEIVE_TIMESTAMP_NS,
+    TICK_FEED_ID,
+    TICK_LINE_ID,
+    TICK_FORMAT_CODE,
+    TICK_TRANSMISSION_NUMBER,
+    TICK_STOCK_CODE,
+    TICK_MATCH_TIME,
+    TICK_CUMULATIVE_VOLUME,
+    TICK_LIMIT_UP_LIMIT_DOWN,
+    TICK_STATUS_NOTE,
+    TICK_TRADE_PRICE,
+    TICK_TRADE_QUANTITY,
+    TICK_BID_PRICE_1,                      // bid_price_1 .. bid_price_5
+    TICK_BID_QUANTITY_1 = TICK_BID_PRICE_1 + 5,
+    TICK_ASK_PRICE_1 = TICK_BID_QUANTITY_1 + 5,
+    TICK_ASK_QUANTITY_1 = TICK_ASK_PRICE_1 + 5,
+    TICK_COLUMN_COUNT = TICK_ASK_QUANTITY_1 + 5
+};
+
+struct TickColumnSpec {
+    const char* name;
+    const char* arrow_format; // Arrow C data interface format: "C" uint8, "I" uint32, "L" uint64, "w:6" binary(6)
+    uint32_t byte_width;
+    bool nullable;            // Trade and book levels are null when the message does not carry them
+};
+
+extern const TickColumnSpec TICK_SCHEMA[TICK_COLUMN_COUNT];
+
+// Fixed-capacity batch of ticks stored column by column in Arrow layout:
+// every column is a contiguous little-endian values buffer, nullable columns
+// add a validity bitmap (LSB first, 1 = valid), and every buffer starts on a
+// 64-byte boundary. Null slots hold zero.
+//
+// Numeric fields are always stored decoded: match_time in microseconds since
+// midnight, prices in 0.0001 units, transmission_number as an integer.
+class TickBatch {
+public:
+    explicit TickBatch(size_t capacity);
+    ~TickBatch();
+
+    TickBatch(const TickBatch&) = delete;
+    TickBatch& operator=(const TickBatch&) = delete;
+
+    // Append one decoded packet; false if the batch is full, the format carries no
+    // ticks or a price is out of range
+    bool append(const Packet& packet);
+
+    // Build a batch holding every tick in packets
+    static std::shared_ptr<TickBatch> from_packets(const std::vector<Packet>& packets);
+
+    size_t size() const { return rows; }
+    size_t capacity() const { return row_capacity; }
+    bool full() const { return rows == row_capacity; }
+    void clear();
+
+    const uint8_t* values(size_t column) const { return storage + values_offset[column]; }
+    uint8_t* mutable_values(size_t column) { return storage + values_offset[column]; }
+
+    // nullptr for non-nullable columns
+    const uint8_t* validity(size_t column) const;
+    uint8_t* mutable_validity(size_t column);
+    size_t null_count(size_t column) const { return nulls[column]; }
+
+    // Mark the rows of a batch filled through mutable_values() as present
+    void set_size(size_t size, const size_t* null_counts);
+
+    // Column index for a name, or -1
+    static int find_column(const std::string& name);
+
+private:
+    void set_valid(size_t column, size_t row);
+
+    uint8_t* storage = nullptr;
+    size_t row_capacity = 0;
+    size_t rows = 0;
+    size_t values_offset[TICK_COLUMN_COUNT];
+    size_t validity_offset[TICK_COLUMN_COUNT];
+    size_t nulls[TICK_COLUMN_COUNT];
+};
+
+using TickBatchCallback = std::function<void(std::shared_ptr<TickBatch>)>;
+
+// Tick file layout (little endian):
+//
+//   TickFileHeader
+//   TickFileColumn[column_count]
+//   { TickFileBatchHeader, per column: [validity], values } ...
+//
+// Every buffer is padded to 8 bytes, so a memory-mapped file can be wrapped
+// column by column without copying (e.g. pyarrow.Array.from_buffers).
+struct TickFileHeader {
+    char magic[8];         // "TWSECOL" + NUL
+    uint32_t version;      // TICK_FILE_VERSION
+    uint32_t column_count;
+};
+
+struct TickFileColumn {
+    char name[32];
+    char arrow_format[8];
+    uint32_t byte_width;
+    uint32_t nullable;
+};
+
+struct TickFileBatchHeader {
+    uint64_t rows;
+    uint64_t bytes; // Size of the column buffers that follow
+};
+
+constexpr uint32_t TICK_FILE_VERSION = 1;
+
+// Writes full batches to a tick file on a background thread
+class TickFileWriter {
+public:
+    TickFileWriter() = default;
+    ~TickFileWriter();
+
+    TickFileWriter(const TickFileWriter&) = delete;
+    TickFileWriter& operator=(const TickFileWriter&) = delete;
+
+    bool open(const std::string& path);
+
+    // Write queued batches and stop the writer thread
+    void close();
+
+    // Queue a batch; the writer holds a reference until it is on disk
+    void write(std::shared_ptr<TickBatch> batch);
+
+    bool is_open() const { return fd >= 0; }
+
+private:
+    void writer_loop();
+    bool write_batch(const TickBatch& batch);
+
+    int fd = -1;
+    std::deque<std::shared_ptr<TickBatch>> queue;
+    std::thread writer_thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+// Read every batch of a tick file
+bool read_tick_file(const std::string& path, std::vector<std::shared_ptr<TickBatch>>& out);
+
+#endif // COLUMNAR_H
@@ -0,0 +1,90 @@
+#ifndef FEED_GENERATOR_H
+#define FEED_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Largest message the generator writes: Format 23 with 1 trade + 5 bids + 5 asks
+constexpr size_t GENERATED_MESSAGE_MAX = 160;
+
+struct FeedGeneratorOptions {
+    size_t symbols = 1000;          // Listed stocks; every other one trades on OTC
+    size_t warrants = 200;          // Warrants announced through Format 14
+    uint64_t seed = 1;
+
+    // Relative share of each format in the stream
+    unsigned weight_06 = 60;        // TWSE quotes
+    unsigned weight_17 = 25;        // OTC quotes
+    unsigned weight_23 = 10;        // Odd-lot quotes (either market)
+    unsigned weight_14 = 5;         // Warrant reference data
+
+    // Datagrams hold a random number of messages in [1, max_messages_per_datagram]
+    size_t max_messages_per_datagram = 8;
+    size_t max_datagram_size = 1400;
+};
+
+// A generated instrument; code is the 6-byte space-padded stock code
+struct GeneratedSymbol {
+    char code[6];
+    uint8_t business_type; // 1 TWSE, 2 OTC
+    uint32_t price;        // 0.0001 units
+    uint32_t tick;         // 0.0001 units
+    uint64_t volume;       // Round-lot cumulative volume
+    uint64_t odd_volume;   // Odd-lot cumulative volume
+};
+
+// Synthetic TWSE/OTC feed: valid Format 6/17/14/23 messages with PACK BCD
+// fields, correct message lengths, checksums and terminal codes, and one
+// increasing transmission_number per format. Prices follow a random walk on
+// each symbol's tick grid, level counts and datagram sizes vary from message
+// to message, and match_time advances through the trading day.
+//
+// Deterministic for a given seed, so benchmark runs see the same stream.
+class FeedGenerator {
+public:
+    explicit FeedGenerator(const FeedGeneratorOptions& options = FeedGeneratorOptions());
+
+    // Write the next message of a randomly chosen format to out (at least
+    // GENERATED_MESSAGE_MAX bytes) and return its length
+    size_t next_message(uint8_t* out);
+
+    // Same, for a given format code (0x06, 0x14, 0x17 or 0x23)
+    size_t next_message(uint8_t* out, uint8_t format_code);
+
+    // Pack one or more messages into out and return the datagram length.
+    // messages, if given, receives the number of messages packed.
+    size_t next_datagram(uint8_t* out, size_t capacity, size_t* messages = nullptr);
+
+    // Next transmission_number (binary) that will be used for a format
+    uint32_t next_sequence(uint8_t format_code) const { return sequences[format_code]; }
+
+    // Skip count transmission numbers of a format, as if the messages were lost upstream
+    void skip_sequence(uint8_t format_code, uint32_t count) { sequences[format_code] += count; }
+
+    const std::vector<GeneratedSymbol>& get_symbols() const { return symbols; }
+
+private:
+    uint64_t random();
+    uint32_t uniform(uint32_t bound);
+    uint8_t pick_format();
+
+    size_t write_quote(uint8_t* out, uint8_t format_code);
+    size_t write_warrant(uint8_t* out);
+    size_t write_header(uint8_t* out, uint8_t business_type, uint8_t format_code);
+    size_t finish_message(uint8_t* out, size_t length);
+    uint64_t advance_clock();
+
+    FeedGeneratorOptions options;
+    uint64_t state;
+    std::vector<GeneratedSymbol> symbols;
+    uint32_t sequences[256] = {};
+    uint64_t clock_us; // Microseconds since midnight
+    size_t next_warrant = 0;
+    unsigned total_weight;
+};
+
+// Write value as right-aligned PACK BCD into bytes bytes, most significant digit first
+void write_bcd(uint8_t* out, uint64_t value, size_t bytes);
+
+#endif // FEED_GENERATOR_H
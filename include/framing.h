@@ -0,0 +1,20 @@
+#ifndef FRAMING_H
+#define FRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Offset of the first 0x0D 0x0A pair in data, or length if there is none.
+// SSE2 scan, 16 candidate positions per step.
+size_t find_terminal_code(const uint8_t* data, size_t length);
+
+// XOR of all bytes in data. AVX2 or SSE2 reduction, chosen at runtime.
+uint8_t xor_checksum(const uint8_t* data, size_t length);
+
+// The kernels xor_checksum chooses from, callable directly so they can be
+// checked against each other. One the CPU or the build lacks runs as Scalar.
+enum class XorKernel { Scalar, SSE2, AVX2 };
+bool has_xor_kernel(XorKernel kernel);
+uint8_t xor_checksum(XorKernel kernel, const uint8_t* data, size_t length);
+
+#endif // FRAMING_H
@@ -1,16 +1,45 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <chrono>
-#include <iomanip>
-#include <sstream>
-#include <iostream>
-#include <sys/stat.h>   // for mkdir
-#include <errno.h>      // for errno
-#include <cstring>      // for strerror
+#include <thread>
+#include <vector>
 
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+// One fixed-size binary record; text or raw bytes are copied in, never formatted, on the caller
+struct LogRecord {
+    uint64_t timestamp_ns;
+    uint32_t suppressed;   // Repeats of this message dropped by the rate limiter just before it
+    LogLevel level;
+    uint8_t is_bytes;      // data holds label then raw bytes to be hex-dumped
+    uint16_t label_length; // Only for is_bytes
+    uint16_t length;       // Bytes used in data (truncated to fit)
+    uint16_t original_length;
+    char data[236];
+};
+
+static_assert(sizeof(LogRecord) == 256, "LogRecord should stay one 256-byte block");
+
+// Asynchronous logger.
+//
+// Each logging thread owns a lock-free SPSC ring of LogRecords, created the
+// first time it logs. log() only checks the level, applies the rate limiter,
+// copies the message into a record and pushes it; if the ring is full the
+// record is dropped and counted. A background thread drains every ring,
+// formats timestamps and hex dumps, and writes the file in blocks.
 class Logger {
 public:
     static Logger& getInstance() {
@@ -18,60 +47,73 @@ public:
         return instance;
     }
 
-    void init(const std::string& filename) {
-        // Create logger directory if it doesn't exist
-        if (mkdir("logger", 0777) == -1) {
-            if (errno != EEXIST) {
-                std::cerr << "Error creating logger directory: " << strerror(errno) << std::endl;
-                return;
-            }
-        }
-
-        // Open log file in logger directory
-        std::string filepath = "logger/" + filename;
-        if (!log_file.is_open()) {
-            log_file.open(filepath, std::ios::out | std::ios::app);
-            if (!log_file.is_open()) {
-                std::cerr << "Error opening log file: " << filepath << std::endl;
-            } else {
-                log("Logger initialized: " + filepath);
-            }
-        }
-    }
+    // Open logger/<filename> and start the writer thread; later calls are ignored
+    void init(const std::string& filename);
 
-    void log(const std::string& message, bool error = false) {
-        if (!log_file.is_open()) return;
-        
-        auto now = std::chrono::system_clock::now();
-        auto now_time_t = std::chrono::system_clock::to_time_t(now);
-        auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            now.time_since_epoch()).count() % 1000000000;
-
-        char timestamp[32];
-        std::tm tm_buf;
-        localtime_r(&now_time_t, &tm_buf);
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
-
-        log_file << "[" << timestamp << "." 
-                << std::setfill('0') << std::setw(9) << now_ns << "] "
-                << (error ? "ERROR: " : "INFO: ") 
-                << message << std::endl;
-
-        if (error) {
-            std::cerr << message << std::endl;
-        }
-    }
+    // Flush everything queued and stop the writer thread
+    void shutdown();
+
+    // Info, or Error (also echoed to stderr)
+    void log(const std::string& message, bool error = false);
+    void log(LogLevel level, const std::string& message);
+    void log(LogLevel level, const char* message);
+
+    // Hex dump of raw bytes; only the bytes are copied on the calling thread
+    void log_bytes(LogLevel level, const char* label, const uint8_t* data, size_t length);
 
-    ~Logger() {
-        if (log_file.is_open()) {
-            log_file.close();
-        }
+    bool should_log(LogLevel level) const {
+        return level >= min_level.load(std::memory_order_relaxed) && initialized.load(std::memory_order_relaxed);
     }
 
+    void set_level(LogLevel level) { min_level.store(level, std::memory_order_relaxed); }
+    LogLevel get_level() const { return min_level.load(std::memory_order_relaxed); }
+
+    // At most this many copies of the same message per second per thread; 0 disables the limit
+    void set_rate_limit(uint32_t per_second) { rate_limit.store(per_second, std::memory_order_relaxed); }
+
+    // Block until every record queued so far is written
+    void flush();
+
+    // Records lost because a thread's ring was full
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Records discarded by the rate limiter
+    uint64_t get_suppressed() const { return suppressed.load(std::memory_order_relaxed); }
+
+    ~Logger();
+
 private:
-    Logger() = default;
+    struct ThreadBuffer;
+
+    Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    void push(LogLevel level, const char* label, size_t label_length, const uint8_t* data, size_t length,
+              bool is_bytes);
+    ThreadBuffer* thread_buffer();
+    void writer_loop();
+    void write_record(const LogRecord& record);
+
     std::ofstream log_file;
-    std::string filtered_stock;  // Stock code to filter
+    std::atomic<bool> initialized{false};
+    std::atomic<LogLevel> min_level{LogLevel::Info};
+    std::atomic<uint32_t> rate_limit{100};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> suppressed{0};
+
+    // Rings of every thread that has logged; retired rings are freed once drained
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    std::thread writer_thread;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> writer_passes{0};
+    std::mutex init_mutex;
+
+    // Timestamp prefix cache; the wall-clock second only changes once a second
+    int64_t cached_second = -1;
+    char cached_timestamp[32];
 };
 
-#endif // LOGGER_H 
\ No newline at end of file
+#endif // LOGGER_H
@@ -0,0 +1,101 @@
+#ifndef MARKET_STATE_H
+#define MARKET_STATE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Parser state kept in a memory-mapped file so a restarted process is warm at
+// once: the SnapshotStore and WarrantIndex tables live in the file, next to
+// the last transmission_number of every (feed_id, format_code) stream.
+//
+// Layout: header, sequence table, snapshot slots, warrant tables, each at a
+// page-aligned offset recorded in the header. The header also records the
+// version, capacities and the sizes of the stored structs; a file that does
+// not match all of them is recreated empty. Changes reach the page cache as
+// they are made, so a crash of the process loses nothing; close() syncs the
+// file to disk for a machine restart.
+struct MarketStateHeader {
+    std::atomic<uint64_t> magic;     // MARKET_STATE_MAGIC, stored last when the file is created
+    uint32_t version;                // MARKET_STATE_VERSION
+    uint32_t header_size;
+    uint32_t snapshot_size;          // sizeof(BookSnapshot) and sizeof(WarrantInfo); guard
+    uint32_t warrant_info_size;      // against layout changes without a version bump
+    uint64_t snapshot_capacity;      // As requested
+    uint64_t warrant_capacity;
+    uint64_t sequence_offset;
+    uint64_t snapshot_offset;
+    uint64_t warrant_offset;
+    uint64_t file_size;
+    std::atomic<uint32_t> clean;     // 1 after a clean close, 0 while a writer has it open
+};
+
+constexpr uint64_t MARKET_STATE_MAGIC = 0x4554415453455354ULL; // "TSESTATE"
+constexpr uint32_t MARKET_STATE_VERSION = 2;
+
+// Streams are indexed like LineArbiter: (feed_id << 8) | format_code
+constexpr size_t MARKET_STATE_STREAMS = 256 * 256;
+
+// How reattached state lines up with the live feed on one stream
+struct StateCheck {
+    bool reattached;         // The file held a sequence number for this stream
+    bool checked;            // A message arrived on it since the file was opened
+    uint32_t saved_sequence; // Last transmission_number in the file (binary)
+    uint32_t first_sequence; // First transmission_number seen since opening
+    uint32_t missed;         // Messages between the two; symbols they touched may be stale
+    bool session_restarted;  // The sequence went back: the file is from an earlier session
+};
+
+class SnapshotStore;
+class WarrantIndex;
+
+class MarketStateFile {
+public:
+    MarketStateFile() = default;
+    ~MarketStateFile();
+
+    MarketStateFile(const MarketStateFile&) = delete;
+    MarketStateFile& operator=(const MarketStateFile&) = delete;
+
+    // Map path, reattaching to the state in it when its layout matches, or
+    // creating it empty. Capacities are those of SnapshotStore / WarrantIndex.
+    bool open(const std::string& path, size_t snapshot_capacity, size_t warrant_capacity);
+
+    // msync and unmap; marks the file as cleanly closed
+    void close();
+
+    // True if open() found existing state rather than creating the file
+    bool reattached() const { return attached; }
+
+    // True if the previous writer did not close the file (crashed or killed)
+    bool recovered_from_crash() const { return unclean; }
+
+    // Stores placed in the file; owned by the caller, valid until close()
+    std::unique_ptr<SnapshotStore> make_snapshot_store();
+    std::unique_ptr<WarrantIndex> make_warrant_index();
+
+    // Writer side: remember the latest transmission_number (binary) of a stream.
+    // Returns true for the first message of a stream with a saved sequence, so
+    // the caller can report check().
+    bool record_sequence(uint8_t feed_id, uint8_t format_code, uint32_t sequence);
+
+    // Any thread
+    StateCheck check(uint8_t feed_id, uint8_t format_code) const;
+
+private:
+    MarketStateHeader* header = nullptr;
+    uint8_t* base = nullptr;
+    size_t mapping_size = 0;
+    bool attached = false;
+    bool unclean = false;
+
+    // Saved position + 1 per stream (0 = none), in the file
+    std::atomic<uint32_t>* sequences = nullptr;
+    // Copy of the saved positions taken at open, and first position seen since (+ 1)
+    std::unique_ptr<uint32_t[]> saved;
+    std::unique_ptr<std::atomic<uint32_t>[]> first_seen;
+};
+
+#endif // MARKET_STATE_H
@@ -1,25 +1,42 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-// define DEBUG to enable debug logging
-// #define DEBUG
+// Diagnostics go through the asynchronous Logger; raise the detail at runtime with
+// Logger::getInstance().set_level(LogLevel::Debug)
 
 #include <thread>
 #include <functional>
 #include <string>
 #include <vector>
 #include <atomic>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
+#include <memory>
+#include <array>
 #include <cstdint>
+#include <cstddef>
 #include <fstream>
+#include <type_traits>
 #include "logger.h"
+#include "spsc_ring.h"
+#include "arbiter.h"
+#include "snapshot_store.h"
+#include "capture.h"
+#include "columnar.h"
+#include "stats.h"
+#include "bar_engine.h"
+#include "symbol.h"
+#include "warrant_index.h"
+#include "market_state.h"
 
 // Callback type for handling recorded packets
 using PacketCallback = std::function<void(const struct Packet&)>;
+using PacketBatchCallback = std::function<void(const struct Packet* packets, size_t count)>;
+
+// Maximum number of price/quantity levels in one message:
+// 1 trade + 5 bids + 5 asks, as bounded by the display_item bitmap
+constexpr size_t PACKET_MAX_LEVELS = 11;
 
 // Packet structure based on specifications
+// Trivially copyable so decoded packets can be memcpy'd into rings and shared memory
 struct Packet {
     // ESC-CODE
     uint8_t esc_code; // ASCII 27 (0x1B)
@@ -38,8 +55,11 @@ struct Packet {
     uint8_t limit_up_limit_down;        // 1 byte, BIT MAP
     uint8_t status_note;          // 1 byte, BIT MAP
     uint64_t cumulative_volume;   // 6 bytes for format 0x23, 4 bytes for 0x06 and 0x17; PACK BCD
-    std::vector<uint32_t> prices; // Prices (each 5 bytes, PACK BCD)
-    std::vector<uint32_t> quantities; // Quantities (each 4 bytes, PACK BCD)
+    uint8_t level_count;          // Number of valid entries in prices / quantities
+    uint32_t prices[PACKET_MAX_LEVELS];     // Prices (each 5 bytes, PACK BCD): the low 4 bytes
+    uint32_t quantities[PACKET_MAX_LEVELS]; // Quantities (4 bytes, or for 0x23 the low 4 of 6; PACK BCD)
+    uint8_t price_high[PACKET_MAX_LEVELS];  // First byte of each price (digits from 10000 up)
+    uint16_t quantity_high[PACKET_MAX_LEVELS]; // First 2 bytes of each 0x23 quantity, 0 otherwise
 
     // BODY for format code 0x14
     char warrant_brief_name[16]; // A. warrant brief name
@@ -56,6 +76,82 @@ struct Packet {
 
     // TERMINAL-CODE
     uint16_t terminal_code; // 2 bytes, HEXACODE 0x0D 0x0A
+
+    // Kernel receive time in ns since epoch (SO_TIMESTAMPNS), 0 if not enabled
+    uint64_t receive_timestamp_ns;
+
+    // Feed the packet arrived on and the index of the subscription (line) within the Parser
+    uint8_t feed_id;
+    uint8_t line_id;
+
+    // 1 when set_decode_bcd is on: match_time is microseconds since midnight,
+    // prices are integers in 0.0001 units and volumes/quantities are plain integers
+    uint8_t bcd_decoded;
+};
+
+static_assert(std::is_trivially_copyable<Packet>::value, "Packet must stay trivially copyable");
+
+// Full 5-byte PACK BCD price of one level of a packet that is not decoded yet
+inline uint64_t raw_price(const Packet& packet, size_t level) {
+    return static_cast<uint64_t>(packet.price_high[level]) << 32 | packet.prices[level];
+}
+
+// Full PACK BCD quantity (6 bytes for format 0x23) of one level of a packet that is not decoded yet
+inline uint64_t raw_quantity(const Packet& packet, size_t level) {
+    return static_cast<uint64_t>(packet.quantity_high[level]) << 32 | packet.quantities[level];
+}
+
+// Decode match_time, cumulative_volume, prices and quantities of a Format 6/17/23
+// packet from PACK BCD in place and set bcd_decoded. Returns false, leaving the
+// packet as it was, if a price does not fit prices[] in 0.0001 units (above 429496.7295)
+// or a quantity does not fit quantities[] (above 4294967295).
+bool decode_packet_bcd(Packet& packet);
+
+// Body decoder signature shared by every format; offset points just past the header
+using BodyDecoder = bool (*)(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset);
+
+// Decoder per format code; nullptr for formats that are not decoded
+using FormatDispatchTable = std::array<BodyDecoder, 256>;
+
+// 256-bit set of format codes, tested with a single shift and mask
+struct FormatBitmap {
+    uint64_t words[4];
+
+    constexpr bool test(uint8_t code) const { return (words[code >> 6] >> (code & 63)) & 1; }
+    constexpr void set(uint8_t code) { words[code >> 6] |= uint64_t(1) << (code & 63); }
+};
+
+template <uint8_t FormatCode> struct FormatTraits;
+
+class ShmPublisher;
+
+// One UDP source serviced by a Parser. Several subscriptions may share a
+// feed_id, e.g. the A and B lines of the same TWSE or OTC feed.
+struct Subscription {
+    uint8_t feed_id = 0;
+    int port = 0;
+    std::string multicast_group; // empty for unicast
+    std::string interface_ip;
+};
+
+// Where the callback runs
+enum class DispatchMode {
+    Inline, // on the receive thread, right after parsing (default)
+    Thread, // on a dedicated dispatch thread fed through a ring
+    Poll    // on whichever thread calls Parser::poll()
+};
+
+// How datagrams reach the receive thread
+enum class IngestBackend {
+    Socket,    // one UDP socket per subscription (default)
+    PacketMmap // one AF_PACKET TPACKET_V3 ring on an interface, parsed in place
+};
+
+// What the receive thread does when the dispatch ring is full
+enum class BackpressurePolicy {
+    DropOldest, // evict the oldest queued packet
+    DropNewest, // discard the packet just parsed
+    Block       // spin until the consumer frees a slot
 };
 
 class Parser {
@@ -64,34 +160,257 @@ public:
     ~Parser();
 
     // Start the UDP stream parsing loop in a new thread
+    // The port (and set_multicast settings) is serviced as feed 0 alongside any added subscriptions
     void start_loop(int port, const PacketCallback& callback);
 
+    // Start the parsing loop over the subscriptions added with add_subscription
+    void start_loop(const PacketCallback& callback);
+
+    // Add a (port, multicast group, interface) source; all sources share one epoll thread
+    void add_subscription(uint8_t feed_id, int port, const std::string& group = "",
+                          const std::string& iface = "");
+
     // Stop the parsing loop and clean up resources
     void end_loop();
 
     // Configure multicast settings
     void set_multicast(const std::string& group, const std::string& iface);
     
-    // Set allowed format codes
+    // Set allowed format codes, written as their decimal digits (23 means 0x23).
+    // Until this is called every format with a decoder is accepted.
     void set_allowed_format_codes(const std::vector<uint8_t>& codes);
-    
+
+    // Decode only a fixed set of formats, e.g. use_formats<0x06, 0x23>().
+    // The dispatch table and filter are built at compile time.
+    template <uint8_t... Codes>
+    void use_formats();
+
+    // Only decode quotes (Format 6, 17 and 23) of these stock codes; other
+    // symbols are dropped right after the header, before the body and checksum
+    // are read. Format 14 reference data is not filtered. An empty list turns
+    // the filter off. Call before start_loop.
+    void set_symbol_filter(const std::vector<std::string>& stock_codes);
+
+    // Receive up to `size` datagrams per recvmmsg() call (1 keeps plain recv())
+    void set_batch_receive(size_t size);
+
+    // Stamp every packet with the kernel receive time (uses the recvmmsg path)
+    void set_kernel_timestamps(bool enable);
+
+    // Pin the receive and dispatch threads to CPU cores (-1 leaves a thread unpinned).
+    // Applied when the loop starts.
+    void set_cpu_affinity(int receive_cpu, int dispatch_cpu = -1);
+
+    // Run the receive and dispatch threads under SCHED_FIFO at this priority (1-99,
+    // 0 keeps the default policy). Needs CAP_SYS_NICE; failures are logged.
+    void set_realtime_priority(int priority);
+
+    // Spin on epoll_wait(0) instead of sleeping until a datagram arrives, trading a
+    // busy core for no wakeup latency. busy_poll_us > 0 also sets SO_BUSY_POLL so
+    // the kernel polls the NIC queue for that long on each receive.
+    void set_busy_poll(bool enable, int busy_poll_us = 0);
+
+    // Socket receive buffer size in bytes (SO_RCVBUFFORCE when permitted, else
+    // SO_RCVBUF capped by net.core.rmem_max); 0 keeps the system default
+    void set_receive_buffer_size(int bytes);
+
+    // Read every subscription from a PACKET_MMAP (TPACKET_V3) ring on interface
+    // instead of UDP sockets, so datagrams are parsed where the kernel wrote them.
+    // An empty interface captures on all of them. A BPF filter keeps only UDP to
+    // the subscribed ports; multicast groups are still joined. Blocks reach user
+    // space when full or after block_timeout_ms. Needs CAP_NET_RAW.
+    void set_ingest_backend(IngestBackend backend, const std::string& interface = "",
+                            size_t ring_size = 32 << 20, int block_timeout_ms = 1);
+
+    // Decouple parsing from the callback through a lock-free ring of decoded packets
+    void set_dispatch_mode(DispatchMode mode, size_t ring_capacity = 65536,
+                           BackpressurePolicy policy = BackpressurePolicy::DropOldest);
+
+    // Deliver up to max_packets queued packets on the calling thread (DispatchMode::Poll)
+    size_t poll(size_t max_packets);
+
+    // Deliver packets in batches of up to max_batch instead of one call per packet.
+    // With DispatchMode::Thread the dispatch thread hands over everything queued at once;
+    // inline delivery hands over the messages of each datagram together. Only while stopped.
+    void set_batch_callback(size_t max_batch, const PacketBatchCallback& callback);
+
+    // Copy up to max_packets queued packets into out (DispatchMode::Poll). Waits up to
+    // timeout_ms for the first packet: 0 returns at once, negative waits until end_loop.
+    size_t poll_batch(Packet* out, size_t max_packets, int timeout_ms);
+
+    // Counters and latency percentiles; safe to call from any thread while running
+    ParserStats stats() const;
+    void reset_stats();
+
+    // Record receive-to-callback latency and callback duration histograms. Without
+    // kernel timestamps each datagram is stamped with the wall clock after recv().
+    void enable_latency_stats(bool enable);
+
+    // Publish stats in Prometheus text format to a file (node_exporter textfile collector)
+    // and/or on http://127.0.0.1:<http_port>/metrics while the loop runs
+    void set_stats_export(const std::string& file_path, int http_port = 0, int interval_ms = 1000);
+
+    // Ring statistics
+    uint64_t get_ring_high_water() const;
+    uint64_t get_ring_drops() const;
+
+    // Append every received datagram (with timestamp and feed id) to a capture file
+    void set_capture_file(const std::string& path);
+
+    // Datagrams not captured because the writer thread fell behind
+    uint64_t get_capture_drops() const;
+
+    // Parse a capture file on the calling thread, as fast as possible or at the original pacing
+    bool replay(const std::string& path, const PacketCallback& callback, bool paced = false);
+
+    // Callback used by parse_buffer(); packets are always delivered inline
+    void set_packet_callback(const PacketCallback& callback);
+
+    // Parse one datagram on the calling thread without a socket (offline decoding, benchmarks)
+    void parse_buffer(const uint8_t* data, size_t length, uint64_t receive_timestamp_ns = 0,
+                      uint8_t feed_id = 0, uint8_t line_id = 0);
+
+    // Convert match_time, cumulative_volume, prices and quantities from PACK BCD to native integers
+    void set_decode_bcd(bool enable);
+
+    // Deliver each transmission_number once per (feed, format), from whichever line arrives first
+    void set_arbitration(bool enable);
+
+    // Called on the receive thread whenever a range of transmission numbers is skipped
+    void set_gap_callback(const GapCallback& callback);
+
+    // Delivered / duplicate / gap / out-of-order counters for one feed
+    ArbitrationStats get_arbitration_stats(uint8_t feed_id) const;
+
+    // Accumulate Format 6/17/23 ticks into columnar batches of `rows` rows; each full
+    // batch is handed to the callback on the receive thread
+    void set_tick_batches(size_t rows, const TickBatchCallback& callback);
+
+    // Write tick batches to a columnar file from a background thread
+    void set_tick_file(const std::string& path, size_t rows = 65536);
+
+    // Hand over the partially filled tick batch (end_loop and replay do this automatically).
+    // Only while stopped: the receive thread owns the batch, so this does nothing while running.
+    void flush_tick_batch();
+
+    // Publish every delivered packet to a shared-memory broadcast ring (see ShmSubscriber)
+    void set_shm_publisher(const std::string& name, size_t capacity = 65536);
+
+    // Keep the latest book of every symbol seen on Format 6/17/23 (call before start_loop)
+    void enable_snapshot_store(size_t capacity = 32768);
+
+    // Copy the latest book for a stock code (0x23 for the odd-lot book); lock-free, any thread
+    bool get_snapshot(const std::string& stock_code, BookSnapshot& out, uint8_t format_code = 0x06) const;
+
+    // Direct access for strategy threads; nullptr unless enabled
+    const SnapshotStore* get_snapshot_store() const;
+
+    // Keep the reference data of every warrant seen on Format 14, indexed by warrant
+    // code and by underlying asset (call before start_loop)
+    void enable_warrant_index(size_t capacity = 65536);
+
+    // Copy a warrant's reference data; lock-free, any thread
+    bool get_warrant(const std::string& warrant_code, WarrantInfo& out) const;
+
+    // Warrants on an underlying stock code (or the raw underlying_asset field)
+    std::vector<WarrantInfo> get_warrants_on(const std::string& underlying) const;
+
+    // Direct access for strategy threads, e.g. to walk a quote's warrants with
+    // first_on / next_on in the callback; nullptr unless enabled
+    const WarrantIndex* get_warrant_index() const;
+
+    // Keep the snapshot store, the warrant index and the last transmission_number of
+    // every (feed, format) stream in a memory-mapped file, enabling both stores. A
+    // restarted process reattaches to the file and is warm at once. Returns true if
+    // existing state was reattached. Call before start_loop.
+    bool set_state_file(const std::string& path, size_t snapshot_capacity = 32768,
+                        size_t warrant_capacity = 65536);
+
+    // Whether reattached state follows on from the live feed: compares the saved
+    // transmission_number of a stream with the first one received since
+    StateCheck get_state_check(uint8_t feed_id, uint8_t format_code) const;
+
+    // Aggregate trades of Format 6/17/23 into per-symbol OHLCV / VWAP bars, one series
+    // per interval (e.g. {1000, 60000}). Call before start_loop; capacity bounds the symbols.
+    void enable_bars(const std::vector<uint32_t>& intervals_ms, size_t capacity = 32768);
+
+    // Completed bars go to this callback on the receive thread instead of the bar queue
+    void set_bar_callback(const BarCallback& callback);
+
+    // Copy up to max_bars completed bars into out; any thread
+    size_t poll_bars(Bar* out, size_t max_bars);
+
+    // Close the bars still open (done by end_loop and replay too). Only while stopped:
+    // the receive thread is the engine's single writer, so this does nothing while running.
+    void flush_bars();
+
+    // Bars dropped because nobody polled the queue
+    uint64_t get_bar_drops() const;
+
 private:
-    // Parsing automaton logic
-    void parse_packet(const std::vector<uint8_t>& raw_packet);
+    // Per-datagram metadata copied into every packet parsed from it
+    struct ReceiveContext {
+        uint64_t receive_timestamp_ns;
+        uint8_t feed_id;
+        uint8_t line_id;
+    };
+    struct ReceiveBuffers;
+
+    // Sources of datagrams for receive_loop (receive_backend.h)
+    class ReceiveBackend;
+    class SocketBackend;
+    class PacketRingBackend;
+    std::unique_ptr<ReceiveBackend> make_packet_ring_backend();
+
+    // Parsing automaton logic; operates in place on a single framed message
+    void parse_packet(const uint8_t* raw_packet, size_t length, const ReceiveContext& context);
+
+    // Split a received datagram on 0D 0A and parse each message in place
+    void parse_datagram(const uint8_t* data, size_t length, const ReceiveContext& context);
+
+    void start_receiving(const std::vector<Subscription>& feeds, const PacketCallback& callback);
+
+    // Packet reading thread logic: one epoll loop over the backend's sources
+    void receive_loop(std::vector<Subscription> feeds);
+
+    // Count, capture and parse one datagram, wherever the backend read it from
+    void receive_datagram(const uint8_t* data, size_t length, const ReceiveContext& context);
+
+    // Socket setup for one subscription; returns -1 on failure
+    int open_socket(const Subscription& subscription);
+
+    // Read all queued datagrams from a socket, with recv() or batched recvmmsg()
+    void drain_socket(int fd, ReceiveContext& context, ReceiveBuffers& buffers);
 
-    // Packet reading thread logic
-    void receive_loop(int port);
+    // Hand a validated packet to the callback or the dispatch ring
+    void deliver(const Packet& packet);
+
+    // Dispatch thread logic
+    void dispatch_loop();
+
+    // Apply CPU affinity and real-time priority to the calling thread
+    void configure_thread(int cpu, const char* role);
+
+    // Run the user callbacks, timing them when latency stats are on
+    void invoke_callback(const Packet& packet);
+    void invoke_batch_callback(const Packet* packets, size_t count);
+    void flush_inline_batch();
+    void record_handoff_latency(const Packet* packets, size_t count, uint64_t now_ns);
 
     // Helper methods for parsing
-    bool parse_header(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset);
+    // All helpers read directly from the receive buffer (pointer + length),
+    // so no bytes are copied between recv() and the callback.
+    bool parse_header(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset);
+    // Body decoders, registered per format code through FormatTraits
+    template <uint8_t FormatCode> friend struct FormatTraits;
     // BODY for format code 0x06, 0x17
-    bool parse_body_06(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset);
+    static bool parse_body_06(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset);
     // BODY for format code 0x14
-    bool parse_body_14(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset);
+    static bool parse_body_14(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset);
     // BODY for format code 0x23
-    bool parse_body_23(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset);
-    bool validate_checksum(const std::vector<uint8_t>& raw_packet, const Packet& packet);
-    bool validate_terminal_code(const std::vector<uint8_t>& raw_packet, const Packet& packet);
+    static bool parse_body_23(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset);
+    bool validate_checksum(const uint8_t* raw_packet, size_t length, const Packet& packet);
+    bool validate_terminal_code(const uint8_t* raw_packet, size_t length, const Packet& packet);
 
     // Determine checksum position dynamically based on packet length
     size_t calculate_checksum_position(size_t packet_length) const;
@@ -102,28 +421,156 @@ private:
 
     // Callback for handling valid packets
     PacketCallback packet_callback;
+    PacketBatchCallback batch_callback;
+    size_t max_batch = 0;
+    std::vector<Packet> batch_buffer; // max_batch packets for poll() and inline delivery
+    size_t batch_pending = 0;         // Packets collected by inline delivery, not yet handed over
 
-    // Synchronization for thread-safe packet handling
-    std::mutex packet_mutex;
-    std::condition_variable packet_cv;
-    std::queue<std::vector<uint8_t>> packet_queue;
+    // Decoupled dispatch between the receive thread and the callback
+    DispatchMode dispatch_mode = DispatchMode::Inline;
+    BackpressurePolicy backpressure_policy = BackpressurePolicy::DropOldest;
+    size_t ring_capacity = 0;
+    std::unique_ptr<SpscRing<Packet>> packet_ring;
+    std::thread dispatch_thread;
+    std::atomic<bool> dispatching{false};
+    std::atomic<uint64_t> ring_high_water{0};
+    std::atomic<uint64_t> ring_drops{0};
 
     // Constants for parsing
     static constexpr uint8_t ESC_CODE = 0x1B;
     static constexpr size_t TERMINAL_CODE_SIZE = 2;
     static constexpr size_t HEADER_LENGTH = 9;
+    static constexpr size_t MAX_DATAGRAM_SIZE = 1500; // Maximum UDP packet size
+    static constexpr int MAX_EPOLL_EVENTS = 16;
 
     // Multicast settings
     std::string multicast_group;
     std::string interface_ip;
     bool use_multicast;
 
+    // Additional sources added with add_subscription
+    std::vector<Subscription> subscriptions;
+
+    // Batched receive settings
+    size_t batch_size = 1;
+    bool kernel_timestamps = false;
+
+    // Receive / dispatch thread placement and polling
+    int receive_cpu = -1;
+    int dispatch_cpu = -1;
+    int realtime_priority = 0;
+    bool busy_poll = false;
+    int busy_poll_us = 0;
+    int receive_buffer_size = 0;
+
+    // Ingest backend
+    IngestBackend ingest_backend = IngestBackend::Socket;
+    std::string packet_interface;
+    size_t packet_ring_size = 32 << 20;
+    int packet_block_timeout_ms = 1;
+
+    bool decode_bcd = false;
+
+    // Raw datagram capture
+    std::string capture_path;
+    std::unique_ptr<CaptureWriter> capture_writer;
+
+    // A/B line arbitration
+    bool arbitration_enabled = false;
+    LineArbiter arbiter;
+
+    // Memory-mapped home of the stores below; declared first so it outlives them
+    std::unique_ptr<MarketStateFile> state_file;
+    void record_state_sequence(const Packet& packet);
+
+    // Per-symbol book cache
+    std::unique_ptr<SnapshotStore> snapshot_store;
+
+    // Format 14 reference data
+    std::unique_ptr<WarrantIndex> warrant_index;
+
+    // OHLCV bars
+    std::unique_ptr<BarEngine> bar_engine;
+    BarCallback bar_callback;
+
+    // Hot-path counters and latency histograms
+    ParserMetrics metrics;
+    bool latency_stats = false;
+    std::string stats_file;
+    int stats_port = 0;
+    int stats_interval_ms = 1000;
+    std::unique_ptr<StatsExporter> stats_exporter;
+
+    // Shared-memory fan-out to other processes
+    std::string shm_name;
+    size_t shm_capacity = 0;
+    std::unique_ptr<ShmPublisher> shm_publisher;
+
+    // Columnar tick export
+    size_t tick_batch_rows = 0;
+    TickBatchCallback tick_callback;
+    std::shared_ptr<TickBatch> tick_batch;
+    std::string tick_file_path;
+    std::unique_ptr<TickFileWriter> tick_writer;
+    void open_tick_file();
+    void close_tick_file();
+    void hand_over_tick_batch();
+
     // Filter settings
-    std::vector<uint8_t> allowed_format_codes;
+    const FormatDispatchTable* dispatch_table;
+    FormatBitmap allowed_formats;
+    bool format_filter_set = false;
+    SymbolSet symbol_filter;
     
-    int sockfd = -1;
+    // Written by end_loop to wake the receive thread
+    int wakeup_fd = -1;
     
-    void log_message(const std::string& message, bool error = false);
+    void log_message(const std::string& message, LogLevel level = LogLevel::Debug);
+    void log_message(const char* message, LogLevel level = LogLevel::Debug);
+    void log_raw_packet(const uint8_t* raw_packet, size_t length);
 };
 
+// Body decoder registry. Adding a format (e.g. 0x01 reference data or 0x13)
+// is one more specialization here and its code in DefaultFormats.
+template <uint8_t FormatCode>
+struct FormatTraits {
+    static constexpr BodyDecoder decode = nullptr;
+};
+
+template <> struct FormatTraits<0x06> { static constexpr BodyDecoder decode = &Parser::parse_body_06; };
+template <> struct FormatTraits<0x14> { static constexpr BodyDecoder decode = &Parser::parse_body_14; };
+template <> struct FormatTraits<0x17> { static constexpr BodyDecoder decode = &Parser::parse_body_06; };
+template <> struct FormatTraits<0x23> { static constexpr BodyDecoder decode = &Parser::parse_body_23; };
+
+template <uint8_t... Codes>
+constexpr FormatDispatchTable make_dispatch_table() {
+    FormatDispatchTable table{};
+    ((table[Codes] = FormatTraits<Codes>::decode), ...);
+    return table;
+}
+
+template <uint8_t... Codes>
+constexpr FormatBitmap make_format_bitmap() {
+    FormatBitmap bitmap{};
+    (bitmap.set(Codes), ...);
+    return bitmap;
+}
+
+// Dispatch table and filter for a fixed set of formats, evaluated at compile time
+template <uint8_t... Codes>
+struct FormatSet {
+    static constexpr FormatDispatchTable table = make_dispatch_table<Codes...>();
+    static constexpr FormatBitmap bitmap = make_format_bitmap<Codes...>();
+};
+
+// Every format this library decodes
+using DefaultFormats = FormatSet<0x06, 0x14, 0x17, 0x23>;
+
+template <uint8_t... Codes>
+void Parser::use_formats() {
+    dispatch_table = &FormatSet<Codes...>::table;
+    allowed_formats = FormatSet<Codes...>::bitmap;
+    format_filter_set = true;
+}
+
 #endif // PARSER_H
@@ -0,0 +1,24 @@
+#ifndef RECEIVE_BACKEND_H
+#define RECEIVE_BACKEND_H
+
+#include <cstdint>
+#include <vector>
+#include "parser.h"
+
+// A source of datagrams for Parser::receive_loop. open() sets up every
+// subscription and registers the descriptors to wait on with the loop's epoll
+// instance, tagging each event with a source index; when one is readable the
+// loop calls drain() with that index, which hands every queued datagram to
+// Parser::receive_datagram. Descriptors are released by the destructor. All
+// calls happen on the receive thread.
+class Parser::ReceiveBackend {
+public:
+    virtual ~ReceiveBackend() = default;
+
+    // Returns false if nothing could be opened
+    virtual bool open(const std::vector<Subscription>& feeds, int epoll_fd) = 0;
+
+    virtual void drain(uint32_t index) = 0;
+};
+
+#endif // RECEIVE_BACKEND_H
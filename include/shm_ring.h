@@ -0,0 +1,102 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "parser.h"
+
+// Single-writer, many-reader broadcast ring of decoded Packets in POSIX shared
+// memory (shm_open). One process parses the feed and publishes; any number of
+// subscriber processes read it with their own cursor, without syscalls and
+// without ever slowing the publisher down.
+//
+// Every slot carries a sequence word used as a seqlock: the writer makes it
+// odd, copies the Packet in and publishes 2 * (sequence + 1). A reader that
+// falls more than `capacity` packets behind detects the overwrite, counts the
+// lost packets and resumes from the oldest packet still in the ring. Packets
+// are copied with memcpy, which is why Packet must stay trivially copyable.
+struct ShmRingHeader {
+    std::atomic<uint64_t> magic;  // SHM_RING_MAGIC, stored last by the publisher
+    uint32_t version;             // SHM_RING_VERSION
+    uint32_t slot_size;           // sizeof(ShmRingSlot); guards against layout mismatches
+    uint64_t capacity;            // Number of slots, a power of two
+    std::atomic<uint32_t> closed; // Set when the publisher stops
+    alignas(64) std::atomic<uint64_t> write_sequence; // Sequence of the next packet to publish
+};
+
+struct alignas(64) ShmRingSlot {
+    std::atomic<uint64_t> sequence;
+    Packet packet;
+};
+
+constexpr uint64_t SHM_RING_MAGIC = 0x474E495257455354ULL; // "TSEWRING"
+constexpr uint32_t SHM_RING_VERSION = 3;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared-memory ring needs lock-free 64-bit atomics");
+
+class ShmPublisher {
+public:
+    ShmPublisher() = default;
+    ~ShmPublisher();
+
+    ShmPublisher(const ShmPublisher&) = delete;
+    ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+    // Create (or replace) the segment, e.g. "/twse_feed"; capacity is rounded up to a power of two
+    bool open(const std::string& name, size_t capacity);
+
+    // Mark the ring closed for subscribers and remove the name
+    void close();
+
+    void publish(const Packet& packet);
+
+    bool is_open() const { return header != nullptr; }
+
+private:
+    std::string name;
+    ShmRingHeader* header = nullptr;
+    ShmRingSlot* slots = nullptr;
+    size_t mapping_size = 0;
+    uint64_t mask = 0;
+    uint64_t next_sequence = 0;
+};
+
+class ShmSubscriber {
+public:
+    ShmSubscriber() = default;
+    ~ShmSubscriber();
+
+    ShmSubscriber(const ShmSubscriber&) = delete;
+    ShmSubscriber& operator=(const ShmSubscriber&) = delete;
+
+    // Attach to a publisher's ring; reading starts with the next packet published
+    bool open(const std::string& name);
+    void close();
+
+    // Copy the next packet, or return false if the reader has caught up
+    bool next(Packet& out);
+
+    // Copy up to max_packets packets. Waits up to timeout_ms for the first one:
+    // 0 returns at once, negative waits until the publisher closes.
+    size_t poll(Packet* out, size_t max_packets, int timeout_ms = 0);
+
+    // Packets overwritten before this reader got to them
+    uint64_t get_lost() const { return lost; }
+
+    // Packets published but not yet read
+    uint64_t get_backlog() const;
+
+    bool publisher_closed() const;
+
+private:
+    const ShmRingHeader* header = nullptr;
+    const ShmRingSlot* slots = nullptr;
+    size_t mapping_size = 0;
+    uint64_t mask = 0;
+    uint64_t cursor = 0;
+    uint64_t lost = 0;
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,91 @@
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct Packet;
+
+// Latest state of one symbol, built from Format 6/17/23 messages
+struct BookSnapshot {
+    char stock_code[6];
+    uint8_t feed_id;
+    uint8_t format_code;
+    uint32_t transmission_number; // As received (PACK BCD)
+    uint64_t match_time;          // Of the last update
+    uint64_t cumulative_volume;
+    uint8_t limit_up_limit_down;
+    uint8_t status_note;
+    // 1 if the last update was decoded (set_decode_bcd): times in microseconds since
+    // midnight, prices in 0.0001 units. Otherwise full PACK BCD values as received.
+    uint8_t bcd_decoded;
+
+    // Last trade; kept across updates that carry no trade
+    bool has_trade;
+    uint64_t trade_match_time;
+    uint64_t trade_price;
+    uint64_t trade_quantity;
+
+    // Top of book as carried by the last update
+    uint8_t bid_count;
+    uint8_t ask_count;
+    uint64_t bid_prices[5];
+    uint64_t bid_quantities[5];
+    uint64_t ask_prices[5];
+    uint64_t ask_quantities[5];
+
+    uint64_t update_count;
+};
+
+// Per-symbol snapshot cache keyed by the 6-byte stock code. Format 0x23
+// (odd-lot) books are kept apart from the board-lot books of the same code,
+// so each lookup names the format code it wants.
+//
+// A flat open-addressing table with linear probing; slots are never removed.
+// Each slot is guarded by a seqlock: the single writer (the receive thread)
+// makes the sequence odd while it updates, and readers retry until they copy a
+// snapshot with the same even sequence before and after. Readers never block
+// the writer and never take a lock.
+class SnapshotStore {
+public:
+    // capacity is rounded up to a power of two; keep it at least 2x the symbol count
+    explicit SnapshotStore(size_t capacity);
+
+    // Keep the table in caller-owned memory of memory_size(capacity) bytes, e.g. a
+    // MarketStateFile. attach keeps the symbols already there instead of clearing it.
+    SnapshotStore(size_t capacity, void* memory, bool attach);
+
+    static size_t memory_size(size_t capacity);
+
+    // Writer side: apply a decoded Format 6/17/23 packet. Returns false if the table is full.
+    bool update(const Packet& packet);
+
+    // Reader side: copy the latest snapshot for a symbol. Safe from any thread.
+    bool lookup(const char* stock_code, BookSnapshot& out, uint8_t format_code = 0x06) const;
+    bool lookup(const std::string& stock_code, BookSnapshot& out, uint8_t format_code = 0x06) const;
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> key;      // Packed stock code and book, 0 when empty
+        std::atomic<uint32_t> sequence; // Odd while the writer is updating
+        BookSnapshot snapshot;
+    };
+
+    // Format 0x06 and 0x17 share the board-lot book; 0x23 has its own
+    static uint64_t book_key(uint64_t stock_key, uint8_t format_code);
+
+    bool lookup_key(uint64_t key, BookSnapshot& out) const;
+
+    std::unique_ptr<Slot[]> owned; // Unless the table lives in caller memory
+    Slot* slots;
+    size_t mask;
+    std::atomic<size_t> count{0};
+};
+
+#endif // SNAPSHOT_STORE_H
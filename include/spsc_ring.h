@@ -0,0 +1,83 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Lock-free single-producer / single-consumer ring of trivially copyable items.
+// Capacity is rounded up to a power of two.
+//
+// Besides the usual try_push / try_pop, the producer may call push_overwrite to
+// evict the oldest item when the ring is full. The consumer therefore claims
+// items with a compare-and-swap on head; a copy taken while the producer was
+// overwriting that slot is discarded because the CAS fails.
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing items must be trivially copyable");
+
+public:
+    explicit SpscRing(size_t capacity) : head(0), tail(0) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots.resize(rounded);
+        mask = rounded - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer: enqueue if there is room, otherwise leave the ring untouched
+    bool try_push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) return false;
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: enqueue, evicting the oldest item when full. Returns true if an item was dropped.
+    bool push_overwrite(const T& item) {
+        bool dropped = false;
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (t - h > mask) {
+            // If the CAS fails the consumer just freed the slot itself
+            dropped = head.compare_exchange_strong(h, h + 1, std::memory_order_acq_rel);
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return dropped;
+    }
+
+    // Consumer: dequeue one item if available
+    bool try_pop(T& item) {
+        size_t h = head.load(std::memory_order_acquire);
+        while (h != tail.load(std::memory_order_acquire)) {
+            item = slots[h & mask];
+            if (head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel)) {
+                return true;
+            }
+            // Producer evicted this slot; h now holds the new head
+        }
+        return false;
+    }
+
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_acquire) - h;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // Consumer and producer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif // SPSC_RING_H
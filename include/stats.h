@@ -0,0 +1,146 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Percentiles of one latency histogram, in nanoseconds
+struct LatencySummary {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+// Point-in-time copy of a Parser's counters
+struct ParserStats {
+    uint64_t datagrams_received;
+    uint64_t bytes_received;
+    uint64_t messages;           // Framed messages handed to the parser
+    uint64_t delivered;          // Packets passed to the callback / ring
+    uint64_t filtered;           // Format code not in the allowed set
+    uint64_t symbol_filtered;    // Stock code not in the symbol filter
+    uint64_t invalid_packets;    // No ESC code
+    uint64_t invalid_headers;
+    uint64_t invalid_bodies;
+    uint64_t checksum_failures;
+    uint64_t terminal_failures;
+    uint64_t duplicates;         // Dropped by A/B arbitration
+    uint64_t ring_drops;         // Dropped by the dispatch ring
+    LatencySummary receive_to_callback; // Socket (or kernel) receive to callback entry
+    LatencySummary callback_duration;
+};
+
+// HDR-style log-linear histogram of nanosecond values.
+//
+// Values below 2^SUB_BUCKET_BITS are exact; above that every power of two is
+// split into 2^SUB_BUCKET_BITS linear sub-buckets, so the relative error is
+// below 1/16 at every magnitude up to 2^64. Buckets are relaxed atomics:
+// record() is one fetch_add plus min/max updates and never locks.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t value) {
+        buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t current = minimum.load(std::memory_order_relaxed);
+        while (value < current && !minimum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        current = maximum.load(std::memory_order_relaxed);
+        while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+
+    LatencySummary summary() const;
+    void reset();
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - SUB_BUCKET_BITS;
+        return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    // Largest value that falls into a bucket
+    static uint64_t bucket_upper_bound(size_t index);
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> minimum;
+    std::atomic<uint64_t> maximum;
+};
+
+// Live counters of one Parser. Each counter is written with relaxed atomics
+// by the thread that owns that stage (receive, dispatch or poll) and may be
+// read from any thread at any time.
+struct ParserMetrics {
+    std::atomic<uint64_t> datagrams_received{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> filtered{0};
+    std::atomic<uint64_t> symbol_filtered{0};
+    std::atomic<uint64_t> invalid_packets{0};
+    std::atomic<uint64_t> invalid_headers{0};
+    std::atomic<uint64_t> invalid_bodies{0};
+    std::atomic<uint64_t> checksum_failures{0};
+    std::atomic<uint64_t> terminal_failures{0};
+    std::atomic<uint64_t> duplicates{0};
+    LatencyHistogram receive_to_callback;
+    LatencyHistogram callback_duration;
+
+    void reset();
+};
+
+// Single-threaded increment of a counter only one thread writes; avoids a locked instruction
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Render stats in the Prometheus text exposition format
+std::string format_prometheus(const ParserStats& stats, const std::string& prefix = "twse_parser");
+
+// Publishes stats periodically to a Prometheus textfile (written atomically
+// through a temporary file and rename) and/or serves them over HTTP on
+// 127.0.0.1:<port> for a local scrape.
+class StatsExporter {
+public:
+    using Source = std::function<ParserStats()>;
+
+    StatsExporter() = default;
+    ~StatsExporter();
+
+    StatsExporter(const StatsExporter&) = delete;
+    StatsExporter& operator=(const StatsExporter&) = delete;
+
+    // file_path may be empty and http_port 0 to disable either output
+    bool start(const Source& source, const std::string& file_path, int http_port, int interval_ms);
+    void stop();
+
+private:
+    void export_loop();
+    void write_file(const std::string& text);
+    void serve_client(int client, const std::string& text);
+
+    Source source;
+    std::string file_path;
+    int listen_fd = -1;
+    int interval_ms = 1000;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+#endif // STATS_H
@@ -0,0 +1,73 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The 6-byte ASCII stock code packed into the low 48 bits of an integer.
+// Codes are space padded on the wire ("2330  "), so a packed key is never 0.
+inline uint64_t pack_stock_code(const char* code) {
+    uint64_t key = 0;
+    std::memcpy(&key, code, 6);
+    return key;
+}
+
+// Pack a user supplied code, padding it with spaces to 6 bytes like the feed does
+inline uint64_t pack_stock_code(const std::string& code) {
+    char padded[6] = {' ', ' ', ' ', ' ', ' ', ' '};
+    std::memcpy(padded, code.data(), code.size() < 6 ? code.size() : 6);
+    return pack_stock_code(padded);
+}
+
+// Multiplicative hash of a packed code, for power-of-two open addressing tables
+inline uint64_t hash_stock_key(uint64_t key) {
+    return (key * 0x9E3779B97F4A7C15ULL) >> 17;
+}
+
+// Set of packed stock codes in a flat open-addressing table kept at most a
+// quarter full, so a lookup is one hash and, almost always, one or two probes
+// into a few kilobytes. Built once and then only read.
+class SymbolSet {
+public:
+    SymbolSet() = default;
+
+    explicit SymbolSet(const std::vector<std::string>& codes) {
+        size_t capacity = 16;
+        while (capacity < codes.size() * 4) capacity <<= 1;
+        slots.assign(capacity, 0);
+        mask = capacity - 1;
+        for (const auto& code : codes) insert(pack_stock_code(code));
+    }
+
+    bool contains(uint64_t key) const {
+        if (count == 0) return false;
+        for (size_t index = hash_stock_key(key) & mask;; index = (index + 1) & mask) {
+            if (slots[index] == key) return true;
+            if (slots[index] == 0) return false;
+        }
+    }
+
+    // code points at 6 bytes of a message
+    bool contains(const char* code) const { return contains(pack_stock_code(code)); }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+private:
+    void insert(uint64_t key) {
+        size_t index = hash_stock_key(key) & mask;
+        while (slots[index] != 0 && slots[index] != key) index = (index + 1) & mask;
+        if (slots[index] == 0) {
+            slots[index] = key;
+            count++;
+        }
+    }
+
+    std::vector<uint64_t> slots;
+    size_t mask = 0;
+    size_t count = 0;
+};
+
+#endif // SYMBOL_H
@@ -0,0 +1,122 @@
+#ifndef WARRANT_INDEX_H
+#define WARRANT_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Packet;
+
+// Reference data of one warrant, from its latest Format 14 message. Text
+// fields are copied as sent (ASCII or Big5, padded).
+struct WarrantInfo {
+    char warrant_code[6];
+    uint8_t business_type;        // As received (PACK BCD), 0x01 TWSE, 0x02 OTC
+    char brief_name[16];
+    char underlying_asset[16];
+    char expiration_date[8];      // YYYYMMDD
+    char warrant_type_D[2];
+    char warrant_type_E[2];
+    char warrant_type_F[2];
+    uint32_t id;                  // Dense, in order of first appearance
+    uint32_t underlying_id;       // Interned underlying, shared by every warrant on it
+    uint64_t update_count;
+};
+
+// Every warrant seen on Format 14, keyed by warrant code, with a secondary
+// index from the underlying asset to its warrants.
+//
+// Warrants get dense ids into a fixed array; a flat open-addressing table maps
+// the packed warrant code to its id. Underlying assets are interned once into
+// a second table (16-byte key, trailing blanks and NULs ignored) that holds the
+// head of a list linking that underlying's warrants through their entries, in
+// the order they first appeared. A 6-byte stock_code from Format 6/17/23 looks
+// up the same key, so a quote is joined to its warrants without allocating.
+//
+// Single writer (the parsing thread). Readers on any thread never lock: ids
+// and list links are published with release stores after the entry is
+// written, and each entry is guarded by a seqlock as in SnapshotStore. A
+// warrant stays listed under the underlying it was first seen with.
+class WarrantIndex {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // capacity bounds the number of warrants
+    explicit WarrantIndex(size_t capacity);
+
+    // Keep the tables in caller-owned memory of memory_size(capacity) bytes, e.g. a
+    // MarketStateFile. attach keeps the warrants already there instead of clearing it.
+    WarrantIndex(size_t capacity, void* memory, bool attach);
+
+    static size_t memory_size(size_t capacity);
+
+    // Writer side: apply a Format 14 packet. Returns false if the index is full.
+    bool update(const Packet& packet);
+
+    // Copy a warrant by its 6-byte code
+    bool lookup(const char* warrant_code, WarrantInfo& out) const;
+    bool lookup(const std::string& warrant_code, WarrantInfo& out) const;
+
+    // Copy a warrant by id
+    bool get(uint32_t id, WarrantInfo& out) const;
+
+    // Walk the warrants on an underlying without copying them:
+    // for (uint32_t id = first_on(code); id != NONE; id = next_on(id)) ...
+    // underlying is a 6-byte stock code, as in Packet::stock_code
+    uint32_t first_on(const char* stock_code) const;
+    uint32_t next_on(uint32_t id) const;
+
+    // Every warrant on an underlying, given as a code or as the 16-byte field
+    std::vector<WarrantInfo> warrants_on(const std::string& underlying) const;
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    size_t underlying_count() const { return underlyings_used.load(std::memory_order_relaxed); }
+    size_t capacity() const { return entry_capacity; }
+
+private:
+    struct Entry {
+        std::atomic<uint32_t> sequence{0}; // Odd while the writer is updating
+        std::atomic<uint32_t> next{NONE};  // Next warrant on the same underlying
+        WarrantInfo info;
+    };
+
+    struct CodeSlot {
+        std::atomic<uint64_t> key{0}; // Packed warrant code, 0 when empty
+        uint32_t id = NONE;
+    };
+
+    struct UnderlyingSlot {
+        std::atomic<uint64_t> low{0}; // First 8 bytes of the padded name, 0 when empty
+        uint64_t high = 0;
+        std::atomic<uint32_t> head{NONE};
+        uint32_t tail = NONE;         // Writer only
+        uint32_t id = NONE;
+    };
+
+    // Underlying key: the name padded with spaces to 16 bytes, as two words
+    static void underlying_key(const char* text, size_t length, uint64_t& low, uint64_t& high);
+
+    // Lay the tables out in memory, either fresh or as a previous writer left them
+    void place(void* memory, bool attach);
+
+    uint32_t find_code(uint64_t key) const;
+    const UnderlyingSlot* find_underlying(uint64_t low, uint64_t high) const;
+    UnderlyingSlot* claim_underlying(uint64_t low, uint64_t high);
+
+    std::unique_ptr<uint8_t[]> owned; // Unless the tables live in caller memory
+    Entry* entries;
+    size_t entry_capacity;
+    std::atomic<size_t> count{0};
+
+    CodeSlot* codes;
+    size_t code_mask;
+
+    UnderlyingSlot* underlyings;
+    size_t underlying_mask;
+    std::atomic<size_t> underlyings_used{0};
+};
+
+#endif // WARRANT_INDEX_H
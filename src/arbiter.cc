@@ -0,0 +1,150 @@
+#include "arbiter.h"
+
+namespace {
+
+// Relaxed increment for counters that only the receive thread writes
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+LineArbiter::LineArbiter() : streams(1 << 16) {}
+
+bool LineArbiter::Stream::test(uint32_t sequence) const {
+    uint32_t bit = sequence % WINDOW;
+    return (seen[bit / 64] >> (bit % 64)) & 1;
+}
+
+void LineArbiter::Stream::set(uint32_t sequence) {
+    uint32_t bit = sequence % WINDOW;
+    seen[bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+void LineArbiter::Stream::clear(uint32_t sequence) {
+    uint32_t bit = sequence % WINDOW;
+    seen[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+}
+
+uint32_t LineArbiter::Stream::window_start() const {
+    return next_expected - first_sequence > WINDOW ? next_expected - WINDOW : first_sequence;
+}
+
+void LineArbiter::Stream::seed(uint32_t sequence) {
+    started = true;
+    first_sequence = sequence;
+    next_expected = sequence + 1;
+    seen.fill(0);
+    gap_open = false;
+    set(sequence);
+}
+
+void LineArbiter::report_gap(uint8_t feed_id, uint8_t format_code, uint32_t first_missing, uint32_t last_missing) {
+    Counters& counter = counters[feed_id];
+    bump(counter.gaps);
+    bump(counter.missing, last_missing - first_missing + 1);
+    if (gap_callback) {
+        GapEvent event{feed_id, format_code, first_missing, last_missing};
+        gap_callback(event);
+    }
+}
+
+void LineArbiter::expire(Stream& stream, uint8_t feed_id, uint8_t format_code, uint32_t from, uint32_t to) {
+    // Below next_expected the window bits say what arrived; above it nothing did
+    uint32_t tracked = to < stream.next_expected ? to : stream.next_expected;
+    for (uint32_t sequence = from; sequence < tracked; ++sequence) {
+        if (!stream.test(sequence)) {
+            if (!stream.gap_open) stream.gap_start = sequence;
+            stream.gap_open = true;
+        } else if (stream.gap_open) {
+            report_gap(feed_id, format_code, stream.gap_start, sequence - 1);
+            stream.gap_open = false;
+        }
+    }
+    if (tracked < to && !stream.gap_open) {
+        stream.gap_start = tracked;
+        stream.gap_open = true;
+    }
+}
+
+bool LineArbiter::accept(uint8_t feed_id, uint8_t format_code, uint32_t transmission_number) {
+    std::unique_ptr<Stream>& slot = streams[(feed_id << 8) | format_code];
+    if (!slot) slot.reset(new Stream());
+    Stream& stream = *slot;
+    Counters& counter = counters[feed_id];
+
+    if (!stream.started) {
+        stream.seed(transmission_number);
+        bump(counter.delivered);
+        return true;
+    }
+
+    if (transmission_number >= stream.next_expected) {
+        // Numbers the window slides past can no longer be filled by the other line
+        uint32_t next = transmission_number + 1;
+        uint32_t new_start = next - stream.first_sequence > WINDOW ? next - WINDOW : stream.first_sequence;
+        uint32_t old_start = stream.window_start();
+        if (new_start > old_start) expire(stream, feed_id, format_code, old_start, new_start);
+
+        // Reuse the bits of the expired numbers for the ones skipped up to this one
+        uint32_t skipped = transmission_number - stream.next_expected;
+        uint32_t to_clear = skipped + 1 < WINDOW ? skipped + 1 : WINDOW;
+        for (uint32_t i = 0; i < to_clear; ++i) {
+            stream.clear(transmission_number - i);
+        }
+        stream.set(transmission_number);
+        stream.next_expected = next;
+        bump(counter.delivered);
+        return true;
+    }
+
+    if (stream.next_expected - transmission_number > WINDOW) {
+        // Too old for a copy from the other line: the feed started a new sequence
+        expire(stream, feed_id, format_code, stream.window_start(), stream.next_expected);
+        stream.seed(transmission_number);
+        bump(counter.resets);
+        bump(counter.delivered);
+        return true;
+    }
+
+    // Inside the window: the first copy of a number the newest one skipped, or a duplicate
+    if (!stream.test(transmission_number)) {
+        stream.set(transmission_number);
+        bump(counter.out_of_order);
+        bump(counter.delivered);
+        return true;
+    }
+
+    bump(counter.duplicates);
+    return false;
+}
+
+void LineArbiter::set_gap_callback(const GapCallback& callback) {
+    gap_callback = callback;
+}
+
+ArbitrationStats LineArbiter::stats(uint8_t feed_id) const {
+    const Counters& counter = counters[feed_id];
+    ArbitrationStats result;
+    result.delivered = counter.delivered.load(std::memory_order_relaxed);
+    result.duplicates = counter.duplicates.load(std::memory_order_relaxed);
+    result.gaps = counter.gaps.load(std::memory_order_relaxed);
+    result.missing = counter.missing.load(std::memory_order_relaxed);
+    result.out_of_order = counter.out_of_order.load(std::memory_order_relaxed);
+    result.resets = counter.resets.load(std::memory_order_relaxed);
+    return result;
+}
+
+void LineArbiter::reset() {
+    for (auto& stream : streams) {
+        stream.reset();
+    }
+    for (auto& counter : counters) {
+        counter.delivered = 0;
+        counter.duplicates = 0;
+        counter.gaps = 0;
+        counter.missing = 0;
+        counter.out_of_order = 0;
+        counter.resets = 0;
+    }
+}
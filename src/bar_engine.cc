@@ -0,0 +1,188 @@
+#include "bar_engine.h"
+#include "bcd.h"
+#include "parser.h"
+#include "symbol.h"
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t ONE_HOUR_US = 3600ULL * 1000000;
+
+// match_time as microseconds since midnight; on the wire it is HHMMSSmmmuuu in PACK BCD
+uint64_t match_time_us(const Packet& packet) {
+    if (packet.bcd_decoded) return packet.match_time;
+    uint64_t value = bcd_to_binary(packet.match_time);
+    uint64_t hours = value / 10000000000ULL;
+    uint64_t minutes = value / 100000000ULL % 100;
+    uint64_t seconds = value / 1000000ULL % 100;
+    return ((hours * 60 + minutes) * 60 + seconds) * 1000000ULL + value % 1000000ULL;
+}
+
+uint64_t decoded(const Packet& packet, uint64_t value) {
+    return packet.bcd_decoded ? value : bcd_to_binary(value);
+}
+
+} // namespace
+
+BarEngine::BarEngine(const std::vector<uint32_t>& intervals_ms, size_t capacity, size_t queue_capacity)
+    : interval_ms(intervals_ms), queue(queue_capacity) {
+    if (interval_ms.empty()) interval_ms.push_back(1000);
+    for (uint32_t& interval : interval_ms) {
+        if (interval == 0) interval = 1000;
+    }
+
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    symbols.reset(new Symbol[rounded]);
+    bars.reset(new OpenBar[rounded * interval_ms.size()]);
+    mask = rounded - 1;
+
+    open_slots.resize(interval_ms.size());
+    current_bucket.assign(interval_ms.size(), 0);
+}
+
+void BarEngine::set_callback(const BarCallback& callback) {
+    this->callback = callback;
+}
+
+bool BarEngine::update(const Packet& packet) {
+    uint64_t time = match_time_us(packet);
+
+    // A clock far behind the latest one is the next session; close what is left of this one
+    if (latest_time > time + ONE_HOUR_US) {
+        flush();
+        latest_time = 0;
+        current_bucket.assign(interval_ms.size(), 0);
+    }
+
+    // Every message, quote or trade, moves the feed clock and may close bars of all symbols
+    if (time > latest_time) {
+        latest_time = time;
+        for (size_t k = 0; k < interval_ms.size(); ++k) {
+            uint64_t bucket = time / (interval_ms[k] * 1000ULL);
+            if (bucket > current_bucket[k]) {
+                close_before(k, bucket);
+                current_bucket[k] = bucket;
+            }
+        }
+    }
+
+    bool has_trade = (packet.display_item & 0b10000000) != 0 && packet.level_count > 0;
+    bool trial = (packet.status_note & 0b10000000) != 0;
+    if (!has_trade || trial) return true;
+
+    // Format 0x06 and 0x17 share the board-lot book; 0x23 has its own
+    uint64_t key = pack_stock_code(packet.stock_code);
+    if (packet.format_code == 0x23) key |= uint64_t(1) << 48;
+
+    size_t slot = SIZE_MAX;
+    for (size_t i = 0, index = hash_stock_key(key) & mask; i <= mask; ++i, index = (index + 1) & mask) {
+        if (symbols[index].key == key || symbols[index].key == 0) {
+            slot = index;
+            break;
+        }
+    }
+    if (slot == SIZE_MAX) return false;
+
+    Symbol& symbol = symbols[slot];
+    symbol.key = key;
+
+    uint64_t full_price = packet.bcd_decoded ? packet.prices[0] : bcd_to_binary(raw_price(packet, 0));
+    if (full_price > UINT32_MAX) return true; // Out of range for a price; skip the trade
+    uint32_t price = static_cast<uint32_t>(full_price);
+    uint64_t quantity = packet.bcd_decoded ? packet.quantities[0] : bcd_to_binary(raw_quantity(packet, 0));
+    uint64_t cumulative = decoded(packet, packet.cumulative_volume);
+
+    // Volume from the cumulative counter, which also covers trades in messages we missed
+    uint64_t volume = 0;
+    if (!symbol.has_volume) {
+        volume = quantity;
+    } else if (cumulative > symbol.cumulative_volume) {
+        volume = cumulative - symbol.cumulative_volume;
+    }
+    if (!symbol.has_volume || cumulative > symbol.cumulative_volume) {
+        symbol.cumulative_volume = cumulative;
+        symbol.has_volume = true;
+    }
+
+    for (size_t k = 0; k < interval_ms.size(); ++k) {
+        uint64_t length = interval_ms[k] * 1000ULL;
+        uint64_t start = time / length * length;
+        OpenBar& entry = open_bar(slot, k);
+        Bar& bar = entry.bar;
+
+        if (entry.active && start > bar.start_time) {
+            // The feed clock has not closed it yet (this trade is ahead of it); do it now
+            emit(bar);
+            entry.active = false;
+        }
+
+        if (!entry.active) {
+            std::memset(&bar, 0, sizeof(Bar));
+            std::memcpy(bar.stock_code, packet.stock_code, 6);
+            bar.format_code = packet.format_code == 0x23 ? 0x23 : 0x06;
+            bar.feed_id = packet.feed_id;
+            bar.interval_ms = interval_ms[k];
+            bar.start_time = start;
+            bar.open = bar.high = bar.low = price;
+            entry.active = true;
+            if (!entry.listed) {
+                open_slots[k].push_back(static_cast<uint32_t>(slot));
+                entry.listed = true;
+            }
+        }
+
+        // A late trade (stamped before the open bar) is folded into the open bar
+        if (price > bar.high) bar.high = price;
+        if (price < bar.low) bar.low = price;
+        bar.close = price;
+        bar.volume += volume;
+        bar.turnover += static_cast<uint64_t>(price) * volume;
+        bar.trade_count++;
+        if (time > bar.last_trade_time) bar.last_trade_time = time;
+        bar.cumulative_volume = symbol.cumulative_volume;
+    }
+    return true;
+}
+
+void BarEngine::close_before(size_t interval, uint64_t bucket) {
+    std::vector<uint32_t>& slots = open_slots[interval];
+    uint64_t length = interval_ms[interval] * 1000ULL;
+    for (size_t i = 0; i < slots.size();) {
+        OpenBar& entry = open_bar(slots[i], interval);
+        if (entry.bar.start_time / length < bucket) {
+            emit(entry.bar);
+            entry.active = false;
+            entry.listed = false;
+            slots[i] = slots.back();
+            slots.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void BarEngine::flush() {
+    for (size_t k = 0; k < interval_ms.size(); ++k) {
+        close_before(k, UINT64_MAX);
+    }
+}
+
+void BarEngine::emit(const Bar& bar) {
+    Bar out = bar;
+    out.vwap = out.volume > 0 ? static_cast<uint32_t>(out.turnover / out.volume) : out.close;
+
+    if (callback) {
+        callback(out);
+    } else if (queue.push_overwrite(out)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t BarEngine::poll(Bar* out, size_t max_bars) {
+    size_t count = 0;
+    while (count < max_bars && queue.try_pop(out[count])) {
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,389 @@
+#include "batch_decoder.h"
+#include "parser.h"
+#include "bcd.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <queue>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t PCAP_MAGIC_US = 0xA1B2C3D4;
+constexpr uint32_t PCAP_MAGIC_NS = 0xA1B23C4D;
+constexpr size_t PCAP_FILE_HEADER_SIZE = 24;
+constexpr size_t PCAP_RECORD_HEADER_SIZE = 16;
+
+constexpr uint32_t LINKTYPE_NULL = 0;
+constexpr uint32_t LINKTYPE_ETHERNET = 1;
+constexpr uint32_t LINKTYPE_RAW = 101;
+constexpr uint32_t LINKTYPE_LINUX_SLL = 113;
+constexpr uint32_t LINKTYPE_LINUX_SLL2 = 276;
+
+inline uint16_t read_be16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+inline uint32_t read_u32(const uint8_t* p, bool swapped) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap32(value) : value;
+}
+
+} // namespace
+
+PcapReader::~PcapReader() {
+    close();
+}
+
+bool PcapReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < PCAP_FILE_HEADER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    const uint8_t* data = static_cast<const uint8_t*>(mapped);
+    uint32_t magic = read_u32(data, false);
+    if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+        swapped = false;
+    } else if (__builtin_bswap32(magic) == PCAP_MAGIC_US || __builtin_bswap32(magic) == PCAP_MAGIC_NS) {
+        swapped = true;
+    } else {
+        munmap(mapped, st.st_size);
+        return false;
+    }
+
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+    nanosecond = read_u32(data, swapped) == PCAP_MAGIC_NS;
+    link_type = read_u32(data + 20, swapped) & 0x0FFFFFFF;
+    mapping = data;
+    mapping_size = st.st_size;
+    offset = PCAP_FILE_HEADER_SIZE;
+    return true;
+}
+
+void PcapReader::close() {
+    if (mapping != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping), mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+}
+
+void PcapReader::add_port_feed(uint16_t port, uint8_t feed_id) {
+    port_feeds.emplace_back(port, feed_id);
+}
+
+bool PcapReader::next(CaptureRecord& record) {
+    while (offset + PCAP_RECORD_HEADER_SIZE <= mapping_size) {
+        const uint8_t* header = mapping + offset;
+        uint32_t seconds = read_u32(header, swapped);
+        uint32_t fraction = read_u32(header + 4, swapped);
+        uint32_t captured = read_u32(header + 8, swapped);
+
+        const uint8_t* frame = header + PCAP_RECORD_HEADER_SIZE;
+        if (offset + PCAP_RECORD_HEADER_SIZE + captured > mapping_size) return false; // Truncated file
+        offset += PCAP_RECORD_HEADER_SIZE + captured;
+
+        if (extract_udp(frame, captured, record)) {
+            record.timestamp_ns = static_cast<uint64_t>(seconds) * 1000000000ULL +
+                                  (nanosecond ? fraction : static_cast<uint64_t>(fraction) * 1000);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Strip the link, IPv4 and UDP headers of one frame
+bool PcapReader::extract_udp(const uint8_t* frame, size_t length, CaptureRecord& record) const {
+    size_t ip_offset;
+    uint16_t ether_type;
+
+    switch (link_type) {
+    case LINKTYPE_ETHERNET:
+        if (length < 14) return false;
+        ether_type = read_be16(frame + 12);
+        ip_offset = 14;
+        // 802.1Q / 802.1ad tags
+        while ((ether_type == 0x8100 || ether_type == 0x88A8) && ip_offset + 4 <= length) {
+            ether_type = read_be16(frame + ip_offset + 2);
+            ip_offset += 4;
+        }
+        if (ether_type != 0x0800) return false;
+        break;
+    case LINKTYPE_LINUX_SLL:
+        if (length < 16 || read_be16(frame + 14) != 0x0800) return false;
+        ip_offset = 16;
+        break;
+    case LINKTYPE_LINUX_SLL2:
+        if (length < 20 || read_be16(frame) != 0x0800) return false;
+        ip_offset = 20;
+        break;
+    case LINKTYPE_NULL:
+        ip_offset = 4;
+        break;
+    case LINKTYPE_RAW:
+        ip_offset = 0;
+        break;
+    default:
+        return false;
+    }
+
+    // IPv4, unfragmented UDP only
+    const uint8_t* ip = frame + ip_offset;
+    if (ip_offset + 20 > length || (ip[0] >> 4) != 4 || ip[9] != 17) return false;
+    size_t ip_header = (ip[0] & 0x0F) * 4;
+    if ((read_be16(ip + 6) & 0x3FFF) != 0) return false;
+
+    const uint8_t* udp = ip + ip_header;
+    if (ip_offset + ip_header + 8 > length) return false;
+    uint16_t port = read_be16(udp + 2);
+    size_t udp_length = read_be16(udp + 4);
+    size_t available = length - ip_offset - ip_header;
+    if (udp_length < 8 || udp_length > available) udp_length = available;
+
+    uint8_t feed_id = 0;
+    if (!port_feeds.empty()) {
+        auto it = std::find_if(port_feeds.begin(), port_feeds.end(),
+                               [port](const std::pair<uint16_t, uint8_t>& entry) { return entry.first == port; });
+        if (it == port_feeds.end()) return false;
+        feed_id = it->second;
+    }
+
+    record.feed_id = feed_id;
+    record.line_id = 0;
+    record.data = udp + 8;
+    record.length = udp_length - 8;
+    return true;
+}
+
+namespace {
+
+// Packets handed to the sink per call
+constexpr size_t SINK_BATCH = 4096;
+
+// (feed_id, business_type, format_code): transmission_number runs independently in each
+inline uint32_t stream_of(const Packet& packet) {
+    return static_cast<uint32_t>(packet.feed_id) << 16 | static_cast<uint32_t>(packet.business_type) << 8 |
+           packet.format_code;
+}
+
+// A jump back by more than the arbitration window is a new session, as in LineArbiter
+inline bool is_restart(uint32_t sequence, uint32_t newest) {
+    return sequence + LineArbiter::WINDOW <= newest;
+}
+
+struct SortEntry {
+    uint32_t stream;
+    uint32_t session; // Counted per stream from the start of the file
+    uint32_t sequence;
+    uint32_t index;   // Into the worker's packets, i.e. arrival order
+
+    bool operator<(const SortEntry& other) const {
+        if (stream != other.stream) return stream < other.stream;
+        if (session != other.session) return session < other.session;
+        if (sequence != other.sequence) return sequence < other.sequence;
+        return index < other.index;
+    }
+};
+
+// Where a stream starts and ends within one chunk, in arrival order
+struct StreamSpan {
+    uint32_t first;
+    uint32_t newest;
+    uint32_t restarts; // Sessions started within the chunk
+    uint32_t base;     // Session of the stream when the chunk starts
+};
+
+struct Worker {
+    std::unique_ptr<Parser> parser;
+    std::vector<Packet> packets;
+    std::vector<SortEntry> order;
+    std::unordered_map<uint32_t, StreamSpan> streams;
+
+    void decode(const CaptureRecord* records, size_t count) {
+        packets.clear();
+        order.clear();
+        streams.clear();
+        for (size_t i = 0; i < count; ++i) {
+            parser->parse_buffer(records[i].data, records[i].length, records[i].timestamp_ns, records[i].feed_id,
+                                 records[i].line_id);
+        }
+
+        order.reserve(packets.size());
+        for (size_t i = 0; i < packets.size(); ++i) {
+            uint32_t stream = stream_of(packets[i]);
+            uint32_t sequence = static_cast<uint32_t>(bcd_to_binary(packets[i].transmission_number));
+            auto found = streams.emplace(stream, StreamSpan{sequence, sequence, 0, 0});
+            StreamSpan& span = found.first->second;
+            if (!found.second) {
+                if (is_restart(sequence, span.newest)) {
+                    span.restarts++;
+                    span.newest = sequence;
+                } else if (sequence > span.newest) {
+                    span.newest = sequence;
+                }
+            }
+            order.push_back(SortEntry{stream, span.restarts, sequence, static_cast<uint32_t>(i)});
+        }
+        std::sort(order.begin(), order.end());
+    }
+};
+
+// Session and newest sequence number of a stream at the end of the chunks merged so far
+struct StreamState {
+    uint32_t session;
+    uint32_t newest;
+};
+
+} // namespace
+
+bool decode_capture_file(const std::string& path, const BatchDecodeOptions& options, const BatchDecodeSink& sink) {
+    CaptureReader capture_reader;
+    PcapReader pcap_reader;
+    bool capture = capture_reader.open(path);
+    if (!capture) {
+        if (!pcap_reader.open(path)) return false;
+        for (const auto& entry : options.port_feeds) {
+            pcap_reader.add_port_feed(entry.first, entry.second);
+        }
+    }
+    bool deduplicate = options.deduplicate && (capture || !options.port_feeds.empty());
+
+    size_t threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+    threads = std::max<size_t>(1, threads);
+    size_t chunk = std::max<size_t>(1, options.chunk_datagrams);
+
+    std::vector<Worker> workers(threads);
+    for (Worker& worker : workers) {
+        worker.parser.reset(new Parser());
+        if (!options.format_codes.empty()) worker.parser->set_allowed_format_codes(options.format_codes);
+        worker.parser->set_decode_bcd(options.decode_bcd);
+        std::vector<Packet>* packets = &worker.packets;
+        worker.parser->set_packet_callback([packets](const Packet& packet) { packets->push_back(packet); });
+    }
+
+    std::unordered_map<uint32_t, StreamState> states;
+    std::unique_ptr<LineArbiter> arbiters[256]; // One per business_type, created on first use
+    std::vector<CaptureRecord> records;
+    records.reserve(threads * chunk);
+    std::vector<Packet> batch;
+    batch.reserve(SINK_BATCH);
+
+    bool more = true;
+    while (more) {
+        // Index the next round of datagrams; records point into the file mapping
+        records.clear();
+        CaptureRecord record;
+        while (records.size() < threads * chunk) {
+            if (!(capture ? capture_reader.next(record) : pcap_reader.next(record))) {
+                more = false;
+                break;
+            }
+            records.push_back(record);
+        }
+        if (records.empty()) break;
+
+        // Each thread decodes and sorts a contiguous chunk with its own Parser
+        size_t per_worker = (records.size() + threads - 1) / threads;
+        std::vector<std::thread> running;
+        for (size_t t = 0; t < threads; ++t) {
+            size_t begin = std::min(records.size(), t * per_worker);
+            size_t end = std::min(records.size(), begin + per_worker);
+            running.emplace_back([&workers, &records, t, begin, end] {
+                workers[t].decode(records.data() + begin, end - begin);
+            });
+        }
+        for (auto& thread : running) thread.join();
+
+        // Chunks were numbered from their own start; carry sessions over in file order
+        for (Worker& worker : workers) {
+            for (auto& entry : worker.streams) {
+                StreamSpan& span = entry.second;
+                auto found = states.emplace(entry.first, StreamState{0, span.newest});
+                StreamState& state = found.first->second;
+                if (found.second) {
+                    span.base = 0;
+                } else if (is_restart(span.first, state.newest)) {
+                    span.base = state.session + 1;
+                    state.newest = span.newest;
+                } else {
+                    span.base = state.session;
+                    state.newest = span.restarts != 0 ? span.newest : std::max(state.newest, span.newest);
+                }
+                state.session = span.base + span.restarts;
+            }
+            // Entries of one stream are contiguous after the sort
+            const StreamSpan* span = nullptr;
+            uint32_t stream = 0;
+            for (SortEntry& entry : worker.order) {
+                if (span == nullptr || entry.stream != stream) {
+                    stream = entry.stream;
+                    span = &worker.streams[stream];
+                }
+                entry.session += span->base;
+            }
+        }
+
+        // Merge the sorted chunks; ties go to the earlier chunk
+        using Head = std::pair<SortEntry, size_t>;
+        auto later = [](const Head& a, const Head& b) {
+            if (a.first.stream != b.first.stream || a.first.session != b.first.session ||
+                a.first.sequence != b.first.sequence) {
+                return b.first < a.first;
+            }
+            return a.second > b.second;
+        };
+        std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+        std::vector<size_t> positions(threads, 0);
+        for (size_t t = 0; t < threads; ++t) {
+            if (!workers[t].order.empty()) heads.emplace(workers[t].order[0], t);
+        }
+
+        while (!heads.empty()) {
+            Head head = heads.top();
+            heads.pop();
+            size_t t = head.second;
+            if (++positions[t] < workers[t].order.size()) heads.emplace(workers[t].order[positions[t]], t);
+
+            const Packet& packet = workers[t].packets[head.first.index];
+            if (deduplicate) {
+                std::unique_ptr<LineArbiter>& arbiter = arbiters[packet.business_type];
+                if (!arbiter) arbiter.reset(new LineArbiter());
+                if (!arbiter->accept(packet.feed_id, packet.format_code, head.first.sequence)) continue;
+            }
+            batch.push_back(packet);
+            if (batch.size() == SINK_BATCH) {
+                sink(batch.data(), batch.size());
+                batch.clear();
+            }
+        }
+        if (!batch.empty()) {
+            sink(batch.data(), batch.size());
+            batch.clear();
+        }
+    }
+    return true;
+}
+
+bool decode_capture_file(const std::string& path, const BatchDecodeOptions& options, std::vector<Packet>& out) {
+    out.clear();
+    return decode_capture_file(path, options, [&out](const Packet* packets, size_t count) {
+        out.insert(out.end(), packets, packets + count);
+    });
+}
@@ -0,0 +1,85 @@
+#include "bcd.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BCD_HAVE_X86_KERNELS 1
+#endif
+
+namespace {
+
+void decode_swar(uint64_t* values, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        values[i] = bcd_to_binary(values[i]);
+    }
+}
+
+#ifdef BCD_HAVE_X86_KERNELS
+
+// Four values per iteration
+__attribute__((target("avx2")))
+void decode_avx2(uint64_t* values, size_t n) {
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+    const __m256i byte_weights = _mm256_set1_epi16(100 << 8 | 1);  // {1, 100} per byte pair
+    const __m256i pair_weights = _mm256_set1_epi32(10000 << 16 | 1); // {1, 10000} per 16-bit pair
+    const __m256i low_dword = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i scale_1e8 = _mm256_set1_epi64x(100000000);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        // Byte -> 0..99: byte - 6 * high_nibble
+        __m256i high = _mm256_and_si256(_mm256_srli_epi64(x, 4), low_nibbles);
+        x = _mm256_sub_epi64(x, _mm256_add_epi64(_mm256_slli_epi64(high, 2), _mm256_slli_epi64(high, 1)));
+        // Byte pairs -> 0..9999 in 16-bit lanes, 16-bit pairs -> 0..99999999 in 32-bit lanes
+        x = _mm256_maddubs_epi16(x, byte_weights);
+        x = _mm256_madd_epi16(x, pair_weights);
+        // 32-bit pairs -> 64-bit value
+        x = _mm256_add_epi64(_mm256_and_si256(x, low_dword),
+                             _mm256_mul_epu32(_mm256_srli_epi64(x, 32), scale_1e8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), x);
+    }
+    decode_swar(values + i, n - i);
+}
+
+// Two values per iteration
+__attribute__((target("ssse3")))
+void decode_ssse3(uint64_t* values, size_t n) {
+    const __m128i low_nibbles = _mm_set1_epi8(0x0F);
+    const __m128i byte_weights = _mm_set1_epi16(100 << 8 | 1);
+    const __m128i pair_weights = _mm_set1_epi32(10000 << 16 | 1);
+    const __m128i low_dword = _mm_set1_epi64x(0xFFFFFFFF);
+    const __m128i scale_1e8 = _mm_set1_epi64x(100000000);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i high = _mm_and_si128(_mm_srli_epi64(x, 4), low_nibbles);
+        x = _mm_sub_epi64(x, _mm_add_epi64(_mm_slli_epi64(high, 2), _mm_slli_epi64(high, 1)));
+        x = _mm_maddubs_epi16(x, byte_weights);
+        x = _mm_madd_epi16(x, pair_weights);
+        x = _mm_add_epi64(_mm_and_si128(x, low_dword),
+                          _mm_mul_epu32(_mm_srli_epi64(x, 32), scale_1e8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), x);
+    }
+    decode_swar(values + i, n - i);
+}
+
+#endif // BCD_HAVE_X86_KERNELS
+
+using DecodeKernel = void (*)(uint64_t*, size_t);
+
+DecodeKernel select_kernel() {
+#ifdef BCD_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return decode_avx2;
+    if (__builtin_cpu_supports("ssse3")) return decode_ssse3;
+#endif
+    return decode_swar;
+}
+
+} // namespace
+
+void bcd_to_binary_batch(uint64_t* values, size_t n) {
+    static const DecodeKernel kernel = select_kernel();
+    kernel(values, n);
+}
@@ -0,0 +1,214 @@
+#include "capture.h"
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char CAPTURE_MAGIC[8] = {'T', 'W', 'S', 'E', 'C', 'A', 'P', '\0'};
+
+uint64_t wall_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter(size_t buffer_size) : buffer_size(buffer_size) {
+    full[0] = false;
+    full[1] = false;
+}
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path) {
+    if (fd >= 0) return false;
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+
+    // New files start with the file header
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        CaptureFileHeader header{};
+        std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.created_ns = wall_clock_ns();
+        if (::write(fd, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        buffers[i].resize(buffer_size);
+        used[i] = 0;
+        full[i] = false;
+    }
+    active = 0;
+    stopping = false;
+    writer_thread = std::thread(&CaptureWriter::writer_loop, this);
+    return true;
+}
+
+void CaptureWriter::close() {
+    if (fd < 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer_thread.join();
+
+    // The writer thread has exited; flush whatever the receive thread left behind
+    for (int i : {1 - active, active}) {
+        if (used[i] > 0) write_buffer(buffers[i], used[i]);
+        used[i] = 0;
+        full[i] = false;
+    }
+
+    ::close(fd);
+    fd = -1;
+}
+
+void CaptureWriter::append(uint64_t timestamp_ns, uint8_t feed_id, uint8_t line_id,
+                           const uint8_t* data, size_t length) {
+    size_t record_size = sizeof(CaptureRecordHeader) + length;
+    if (record_size > buffer_size) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (used[active] + record_size > buffer_size) {
+        int other = 1 - active;
+        if (full[other].load(std::memory_order_acquire)) {
+            // Writer is still busy with the other buffer; never block the feed
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            full[active].store(true, std::memory_order_release);
+        }
+        cv.notify_one();
+        active = other;
+    }
+
+    CaptureRecordHeader header{};
+    header.timestamp_ns = timestamp_ns != 0 ? timestamp_ns : wall_clock_ns();
+    header.length = static_cast<uint16_t>(length);
+    header.feed_id = feed_id;
+    header.line_id = line_id;
+
+    uint8_t* out = buffers[active].data() + used[active];
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), data, length);
+    used[active] += record_size;
+}
+
+void CaptureWriter::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return stopping || full[0] || full[1]; });
+
+        for (int i = 0; i < 2; ++i) {
+            if (!full[i]) continue;
+            lock.unlock();
+            write_buffer(buffers[i], used[i]);
+            used[i] = 0;
+            lock.lock();
+            full[i].store(false, std::memory_order_release);
+        }
+
+        if (stopping) break;
+    }
+}
+
+void CaptureWriter::write_buffer(std::vector<uint8_t>& buffer, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd, buffer.data() + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+bool CaptureReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CaptureFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    CaptureFileHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+    if (std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 || header.version != CAPTURE_VERSION) {
+        munmap(mapped, st.st_size);
+        return false;
+    }
+
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+    mapping = static_cast<const uint8_t*>(mapped);
+    mapping_size = st.st_size;
+    offset = sizeof(CaptureFileHeader);
+    return true;
+}
+
+void CaptureReader::close() {
+    if (mapping != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping), mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    size_t next_offset = read_record(mapping, mapping_size, offset, record);
+    if (next_offset == 0) return false;
+    offset = next_offset;
+    return true;
+}
+
+void CaptureReader::rewind() {
+    offset = sizeof(CaptureFileHeader);
+}
+
+size_t CaptureReader::read_record(const uint8_t* data, size_t size, size_t offset, CaptureRecord& record) {
+    if (data == nullptr || offset + sizeof(CaptureRecordHeader) > size) return 0;
+
+    CaptureRecordHeader header;
+    std::memcpy(&header, data + offset, sizeof(header));
+    size_t payload = offset + sizeof(header);
+    if (payload + header.length > size) return 0;
+
+    record.timestamp_ns = header.timestamp_ns;
+    record.feed_id = header.feed_id;
+    record.line_id = header.line_id;
+    record.data = data + payload;
+    record.length = header.length;
+    return payload + header.length;
+}
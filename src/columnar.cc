@@ -0,0 +1,388 @@
+#include "columnar.h"
+#include "parser.h"
+#include "bcd.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const TickColumnSpec TICK_SCHEMA[TICK_COLUMN_COUNT] = {
+    {"receive_timestamp_ns", "L", 8, false},
+    {"feed_id", "C", 1, false},
+    {"line_id", "C", 1, false},
+    {"format_code", "C", 1, false},
+    {"transmission_number", "I", 4, false},
+    {"stock_code", "w:6", 6, false},
+    {"match_time", "L", 8, false},
+    {"cumulative_volume", "L", 8, false},
+    {"limit_up_limit_down", "C", 1, false},
+    {"status_note", "C", 1, false},
+    {"trade_price", "I", 4, true},
+    {"trade_quantity", "I", 4, true},
+    {"bid_price_1", "I", 4, true},
+    {"bid_price_2", "I", 4, true},
+    {"bid_price_3", "I", 4, true},
+    {"bid_price_4", "I", 4, true},
+    {"bid_price_5", "I", 4, true},
+    {"bid_quantity_1", "I", 4, true},
+    {"bid_quantity_2", "I", 4, true},
+    {"bid_quantity_3", "I", 4, true},
+    {"bid_quantity_4", "I", 4, true},
+    {"bid_quantity_5", "I", 4, true},
+    {"ask_price_1", "I", 4, true},
+    {"ask_price_2", "I", 4, true},
+    {"ask_price_3", "I", 4, true},
+    {"ask_price_4", "I", 4, true},
+    {"ask_price_5", "I", 4, true},
+    {"ask_quantity_1", "I", 4, true},
+    {"ask_quantity_2", "I", 4, true},
+    {"ask_quantity_3", "I", 4, true},
+    {"ask_quantity_4", "I", 4, true},
+    {"ask_quantity_5", "I", 4, true},
+};
+
+namespace {
+
+const char TICK_FILE_MAGIC[8] = {'T', 'W', 'S', 'E', 'C', 'O', 'L', '\0'};
+
+constexpr size_t BUFFER_ALIGNMENT = 64;
+
+inline size_t align_to(size_t size, size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+inline size_t bitmap_bytes(size_t rows) {
+    return (rows + 7) / 8;
+}
+
+template <typename T>
+inline void store(uint8_t* column, size_t row, T value) {
+    std::memcpy(column + row * sizeof(T), &value, sizeof(T));
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+TickBatch::TickBatch(size_t capacity) : row_capacity(capacity) {
+    size_t total = 0;
+    for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+        values_offset[c] = total;
+        total += align_to(capacity * TICK_SCHEMA[c].byte_width, BUFFER_ALIGNMENT);
+        validity_offset[c] = total;
+        if (TICK_SCHEMA[c].nullable) total += align_to(bitmap_bytes(capacity), BUFFER_ALIGNMENT);
+    }
+
+    void* memory = nullptr;
+    if (posix_memalign(&memory, BUFFER_ALIGNMENT, total == 0 ? BUFFER_ALIGNMENT : total) != 0) {
+        throw std::bad_alloc();
+    }
+    storage = static_cast<uint8_t*>(memory);
+    std::memset(storage, 0, total);
+    std::memset(nulls, 0, sizeof(nulls));
+}
+
+TickBatch::~TickBatch() {
+    std::free(storage);
+}
+
+const uint8_t* TickBatch::validity(size_t column) const {
+    return TICK_SCHEMA[column].nullable ? storage + validity_offset[column] : nullptr;
+}
+
+uint8_t* TickBatch::mutable_validity(size_t column) {
+    return TICK_SCHEMA[column].nullable ? storage + validity_offset[column] : nullptr;
+}
+
+void TickBatch::clear() {
+    for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+        std::memset(storage + values_offset[c], 0, rows * TICK_SCHEMA[c].byte_width);
+        if (TICK_SCHEMA[c].nullable) std::memset(storage + validity_offset[c], 0, bitmap_bytes(rows));
+    }
+    std::memset(nulls, 0, sizeof(nulls));
+    rows = 0;
+}
+
+void TickBatch::set_size(size_t size, const size_t* null_counts) {
+    rows = size < row_capacity ? size : row_capacity;
+    for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+        nulls[c] = null_counts != nullptr ? null_counts[c] : 0;
+    }
+}
+
+int TickBatch::find_column(const std::string& name) {
+    for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+        if (name == TICK_SCHEMA[c].name) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+void TickBatch::set_valid(size_t column, size_t row) {
+    storage[validity_offset[column] + row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+}
+
+bool TickBatch::append(const Packet& raw) {
+    if (rows == row_capacity || raw.format_code == 0x14) return false;
+
+    Packet packet = raw;
+    if (!packet.bcd_decoded && !decode_packet_bcd(packet)) return false;
+
+    size_t row = rows;
+    store<uint64_t>(mutable_values(TICK_RECEIVE_TIMESTAMP_NS), row, packet.receive_timestamp_ns);
+    store<uint8_t>(mutable_values(TICK_FEED_ID), row, packet.feed_id);
+    store<uint8_t>(mutable_values(TICK_LINE_ID), row, packet.line_id);
+    store<uint8_t>(mutable_values(TICK_FORMAT_CODE), row, packet.format_code);
+    store<uint32_t>(mutable_values(TICK_TRANSMISSION_NUMBER), row,
+                    static_cast<uint32_t>(bcd_to_binary(packet.transmission_number)));
+    std::memcpy(mutable_values(TICK_STOCK_CODE) + row * 6, packet.stock_code, 6);
+    store<uint64_t>(mutable_values(TICK_MATCH_TIME), row, packet.match_time);
+    store<uint64_t>(mutable_values(TICK_CUMULATIVE_VOLUME), row, packet.cumulative_volume);
+    store<uint8_t>(mutable_values(TICK_LIMIT_UP_LIMIT_DOWN), row, packet.limit_up_limit_down);
+    store<uint8_t>(mutable_values(TICK_STATUS_NOTE), row, packet.status_note);
+
+    // display_item: bit 7 trade, bits 6-4 bid levels, bits 3-1 ask levels
+    bool has_trade = (packet.display_item & 0b10000000) != 0;
+    size_t bid_count = (packet.display_item & 0b01110000) >> 4;
+    size_t ask_count = (packet.display_item & 0b00001110) >> 1;
+    if (bid_count > 5) bid_count = 5;
+    if (ask_count > 5) ask_count = 5;
+
+    size_t level = 0;
+    if (has_trade && level < packet.level_count) {
+        store<uint32_t>(mutable_values(TICK_TRADE_PRICE), row, packet.prices[level]);
+        store<uint32_t>(mutable_values(TICK_TRADE_QUANTITY), row, packet.quantities[level]);
+        set_valid(TICK_TRADE_PRICE, row);
+        set_valid(TICK_TRADE_QUANTITY, row);
+        level++;
+    } else {
+        nulls[TICK_TRADE_PRICE]++;
+        nulls[TICK_TRADE_QUANTITY]++;
+    }
+
+    for (size_t i = 0; i < 5; ++i) {
+        if (i < bid_count && level < packet.level_count) {
+            store<uint32_t>(mutable_values(TICK_BID_PRICE_1 + i), row, packet.prices[level]);
+            store<uint32_t>(mutable_values(TICK_BID_QUANTITY_1 + i), row, packet.quantities[level]);
+            set_valid(TICK_BID_PRICE_1 + i, row);
+            set_valid(TICK_BID_QUANTITY_1 + i, row);
+            level++;
+        } else {
+            nulls[TICK_BID_PRICE_1 + i]++;
+            nulls[TICK_BID_QUANTITY_1 + i]++;
+        }
+    }
+
+    for (size_t i = 0; i < 5; ++i) {
+        if (i < ask_count && level < packet.level_count) {
+            store<uint32_t>(mutable_values(TICK_ASK_PRICE_1 + i), row, packet.prices[level]);
+            store<uint32_t>(mutable_values(TICK_ASK_QUANTITY_1 + i), row, packet.quantities[level]);
+            set_valid(TICK_ASK_PRICE_1 + i, row);
+            set_valid(TICK_ASK_QUANTITY_1 + i, row);
+            level++;
+        } else {
+            nulls[TICK_ASK_PRICE_1 + i]++;
+            nulls[TICK_ASK_QUANTITY_1 + i]++;
+        }
+    }
+
+    rows++;
+    return true;
+}
+
+std::shared_ptr<TickBatch> TickBatch::from_packets(const std::vector<Packet>& packets) {
+    size_t ticks = 0;
+    for (const Packet& packet : packets) {
+        if (packet.format_code != 0x14) ticks++;
+    }
+
+    std::shared_ptr<TickBatch> batch = std::make_shared<TickBatch>(ticks);
+    for (const Packet& packet : packets) {
+        batch->append(packet);
+    }
+    return batch;
+}
+
+TickFileWriter::~TickFileWriter() {
+    close();
+}
+
+bool TickFileWriter::open(const std::string& path) {
+    if (fd >= 0) return false;
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+
+    // New files start with the file header and the schema; later runs append batches
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        TickFileHeader header{};
+        std::memcpy(header.magic, TICK_FILE_MAGIC, sizeof(header.magic));
+        header.version = TICK_FILE_VERSION;
+        header.column_count = TICK_COLUMN_COUNT;
+
+        std::vector<TickFileColumn> columns(TICK_COLUMN_COUNT);
+        for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+            std::memset(&columns[c], 0, sizeof(TickFileColumn));
+            std::strncpy(columns[c].name, TICK_SCHEMA[c].name, sizeof(columns[c].name) - 1);
+            std::strncpy(columns[c].arrow_format, TICK_SCHEMA[c].arrow_format, sizeof(columns[c].arrow_format) - 1);
+            columns[c].byte_width = TICK_SCHEMA[c].byte_width;
+            columns[c].nullable = TICK_SCHEMA[c].nullable;
+        }
+
+        if (!write_all(fd, &header, sizeof(header)) ||
+            !write_all(fd, columns.data(), columns.size() * sizeof(TickFileColumn))) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+
+    stopping = false;
+    writer_thread = std::thread(&TickFileWriter::writer_loop, this);
+    return true;
+}
+
+void TickFileWriter::close() {
+    if (fd < 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer_thread.join();
+
+    ::close(fd);
+    fd = -1;
+}
+
+void TickFileWriter::write(std::shared_ptr<TickBatch> batch) {
+    if (fd < 0 || !batch || batch->size() == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(batch));
+    }
+    cv.notify_one();
+}
+
+void TickFileWriter::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return stopping || !queue.empty(); });
+
+        // Drain the queue before honouring a stop request
+        while (!queue.empty()) {
+            std::shared_ptr<TickBatch> batch = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            write_batch(*batch);
+            lock.lock();
+        }
+
+        if (stopping) break;
+    }
+}
+
+bool TickFileWriter::write_batch(const TickBatch& batch) {
+    static const uint8_t padding[8] = {0};
+    size_t rows = batch.size();
+
+    TickFileBatchHeader header{};
+    header.rows = rows;
+    for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+        if (TICK_SCHEMA[c].nullable) header.bytes += align_to(bitmap_bytes(rows), 8);
+        header.bytes += align_to(rows * TICK_SCHEMA[c].byte_width, 8);
+    }
+    if (!write_all(fd, &header, sizeof(header))) return false;
+
+    for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+        if (TICK_SCHEMA[c].nullable) {
+            size_t size = bitmap_bytes(rows);
+            if (!write_all(fd, batch.validity(c), size) ||
+                !write_all(fd, padding, align_to(size, 8) - size)) {
+                return false;
+            }
+        }
+        size_t size = rows * TICK_SCHEMA[c].byte_width;
+        if (!write_all(fd, batch.values(c), size) || !write_all(fd, padding, align_to(size, 8) - size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool read_tick_file(const std::string& path, std::vector<std::shared_ptr<TickBatch>>& out) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    auto read_all = [fd](void* data, size_t size) {
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+        while (size > 0) {
+            ssize_t n = ::read(fd, bytes, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            bytes += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    };
+
+    // The schema must match the one this build writes
+    TickFileHeader header;
+    bool ok = read_all(&header, sizeof(header)) &&
+              std::memcmp(header.magic, TICK_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == TICK_FILE_VERSION && header.column_count == TICK_COLUMN_COUNT;
+    for (size_t c = 0; ok && c < TICK_COLUMN_COUNT; ++c) {
+        TickFileColumn column;
+        ok = read_all(&column, sizeof(column)) &&
+             std::strncmp(column.name, TICK_SCHEMA[c].name, sizeof(column.name)) == 0 &&
+             column.byte_width == TICK_SCHEMA[c].byte_width;
+    }
+    if (!ok) {
+        ::close(fd);
+        return false;
+    }
+
+    TickFileBatchHeader batch_header;
+    std::vector<uint8_t> skip;
+    while (read_all(&batch_header, sizeof(batch_header))) {
+        size_t rows = batch_header.rows;
+        std::shared_ptr<TickBatch> batch = std::make_shared<TickBatch>(rows);
+        size_t null_counts[TICK_COLUMN_COUNT] = {0};
+
+        for (size_t c = 0; ok && c < TICK_COLUMN_COUNT; ++c) {
+            if (TICK_SCHEMA[c].nullable) {
+                size_t size = bitmap_bytes(rows);
+                skip.resize(align_to(size, 8) - size);
+                ok = read_all(batch->mutable_validity(c), size) && read_all(skip.data(), skip.size());
+                for (size_t row = 0; ok && row < rows; ++row) {
+                    if ((batch->validity(c)[row / 8] & (1u << (row % 8))) == 0) null_counts[c]++;
+                }
+            }
+            size_t size = rows * TICK_SCHEMA[c].byte_width;
+            skip.resize(align_to(size, 8) - size);
+            ok = ok && read_all(batch->mutable_values(c), size) && read_all(skip.data(), skip.size());
+        }
+        if (!ok) break; // Truncated last batch
+
+        batch->set_size(rows, null_counts);
+        out.push_back(std::move(batch));
+    }
+
+    ::close(fd);
+    return true;
+}
@@ -0,0 +1,249 @@
+#include "feed_generator.h"
+#include "framing.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t ESC = 0x1B;
+constexpr size_t HEADER_SIZE = 9;
+constexpr size_t TRAILER_SIZE = 3; // checksum + 0D 0A
+
+constexpr uint64_t MARKET_OPEN_US = 9ULL * 3600 * 1000000;
+constexpr uint64_t MARKET_CLOSE_US = (13ULL * 3600 + 30 * 60) * 1000000;
+
+// TWSE tick sizes by price band, in 0.0001 units
+uint32_t tick_for(uint32_t price) {
+    if (price < 100000) return 100;      // < 10: 0.01
+    if (price < 500000) return 500;      // < 50: 0.05
+    if (price < 1000000) return 1000;    // < 100: 0.1
+    if (price < 5000000) return 5000;    // < 500: 0.5
+    if (price < 10000000) return 10000;  // < 1000: 1
+    return 50000;                        // 5
+}
+
+void pad_ascii(char* out, size_t size, const char* text) {
+    size_t length = strlen(text);
+    if (length > size) length = size;
+    std::memcpy(out, text, length);
+    std::memset(out + length, ' ', size - length);
+}
+
+} // namespace
+
+void write_bcd(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+        uint8_t low = static_cast<uint8_t>(value % 10);
+        value /= 10;
+        uint8_t high = static_cast<uint8_t>(value % 10);
+        value /= 10;
+        out[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+}
+
+FeedGenerator::FeedGenerator(const FeedGeneratorOptions& options)
+    : options(options), state(options.seed * 0x9E3779B97F4A7C15ULL + 1), clock_us(MARKET_OPEN_US) {
+    if (this->options.symbols == 0) this->options.symbols = 1;
+    if (this->options.max_messages_per_datagram == 0) this->options.max_messages_per_datagram = 1;
+    total_weight = options.weight_06 + options.weight_17 + options.weight_23 + options.weight_14;
+    if (total_weight == 0) {
+        this->options.weight_06 = 1;
+        total_weight = 1;
+    }
+
+    symbols.resize(this->options.symbols);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        GeneratedSymbol& symbol = symbols[i];
+        char code[8];
+        if (i < 8899) {
+            snprintf(code, sizeof(code), "%04zu", 1101 + i);
+        } else {
+            snprintf(code, sizeof(code), "%06zu", 100000 + i);
+        }
+        pad_ascii(symbol.code, 6, code);
+        symbol.business_type = i % 2 == 0 ? 1 : 2;
+
+        // Spread starting prices from 5 to about 1000, snapped to the tick grid
+        uint32_t price = 50000 + uniform(10000000);
+        symbol.tick = tick_for(price);
+        symbol.price = price - price % symbol.tick;
+        symbol.volume = 0;
+        symbol.odd_volume = 0;
+    }
+
+    for (uint32_t& sequence : sequences) sequence = 1;
+}
+
+// xorshift64*: fast enough to generate at line rate, and reproducible
+uint64_t FeedGenerator::random() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+uint32_t FeedGenerator::uniform(uint32_t bound) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(static_cast<uint32_t>(random() >> 32)) * bound) >> 32);
+}
+
+uint8_t FeedGenerator::pick_format() {
+    uint32_t draw = uniform(total_weight);
+    if (draw < options.weight_06) return 0x06;
+    draw -= options.weight_06;
+    if (draw < options.weight_17) return 0x17;
+    draw -= options.weight_17;
+    if (draw < options.weight_23) return 0x23;
+    return 0x14;
+}
+
+size_t FeedGenerator::next_message(uint8_t* out) {
+    return next_message(out, pick_format());
+}
+
+size_t FeedGenerator::next_message(uint8_t* out, uint8_t format_code) {
+    if (format_code == 0x14) return write_warrant(out);
+    return write_quote(out, format_code);
+}
+
+size_t FeedGenerator::next_datagram(uint8_t* out, size_t capacity, size_t* messages) {
+    size_t limit = capacity < options.max_datagram_size ? capacity : options.max_datagram_size;
+    size_t wanted = 1 + uniform(static_cast<uint32_t>(options.max_messages_per_datagram));
+
+    size_t length = 0;
+    size_t count = 0;
+    while (count < wanted && (count == 0 || length + GENERATED_MESSAGE_MAX <= limit)) {
+        length += next_message(out + length);
+        count++;
+    }
+    if (messages != nullptr) *messages = count;
+    return length;
+}
+
+uint64_t FeedGenerator::advance_clock() {
+    clock_us += uniform(100);
+    if (clock_us >= MARKET_CLOSE_US) clock_us = MARKET_OPEN_US;
+    return clock_us;
+}
+
+size_t FeedGenerator::write_header(uint8_t* out, uint8_t business_type, uint8_t format_code) {
+    out[0] = ESC;
+    // out[1..2] (message length) is filled in by finish_message
+    write_bcd(out + 3, business_type, 1);
+    out[4] = format_code;
+    out[5] = format_code == 0x23 ? 0x01 : format_code == 0x14 ? 0x03 : 0x04;
+    write_bcd(out + 6, sequences[format_code]++ % 100000000, 4);
+    return 1 + HEADER_SIZE;
+}
+
+size_t FeedGenerator::finish_message(uint8_t* out, size_t length) {
+    write_bcd(out + 1, length + TRAILER_SIZE, 2);
+    out[length] = xor_checksum(out + 1, length - 1);
+    out[length + 1] = 0x0D;
+    out[length + 2] = 0x0A;
+    return length + TRAILER_SIZE;
+}
+
+size_t FeedGenerator::write_quote(uint8_t* out, uint8_t format_code) {
+    bool odd_lot = format_code == 0x23;
+
+    // Half of the traffic goes to the first tenth of the symbols, as on a real session
+    size_t hot = symbols.size() / 10 + 1;
+    size_t index = uniform(2) == 0 ? uniform(static_cast<uint32_t>(hot))
+                                   : uniform(static_cast<uint32_t>(symbols.size()));
+    // Even symbols are TWSE and odd ones OTC; Format 6 and 17 move to a neighbour on their market
+    if (format_code == 0x06) index &= ~size_t(1);
+    if (format_code == 0x17) index |= 1;
+    if (index >= symbols.size()) index = symbols.size() > 2 ? index - 2 : 0;
+    GeneratedSymbol& symbol = symbols[index];
+
+    // Random walk of one tick at most
+    uint32_t move = uniform(4);
+    if (move == 0 && symbol.price > symbol.tick * 10) symbol.price -= symbol.tick;
+    if (move == 1) symbol.price += symbol.tick;
+    symbol.tick = tick_for(symbol.price);
+    symbol.price -= symbol.price % symbol.tick;
+
+    bool trade = uniform(2) == 0;
+    uint32_t bids = uniform(6);
+    uint32_t asks = uniform(6);
+    uint32_t trade_quantity = odd_lot ? 1 + uniform(999) : 1 + uniform(50);
+    if (trade) {
+        if (odd_lot) symbol.odd_volume += trade_quantity;
+        else symbol.volume += trade_quantity;
+    }
+
+    size_t quantity_bytes = odd_lot ? 6 : 4;
+    size_t volume_bytes = odd_lot ? 6 : 4;
+    uint64_t volume_modulus = odd_lot ? 1000000000000ULL : 100000000ULL;
+
+    size_t length = write_header(out, format_code == 0x23 ? symbol.business_type : format_code == 0x17 ? 2 : 1,
+                                 format_code);
+    std::memcpy(out + length, symbol.code, 6);
+    length += 6;
+
+    uint64_t time = advance_clock();
+    uint64_t hhmmss = (time / 3600000000ULL) * 10000 + (time / 60000000ULL % 60) * 100 + time / 1000000 % 60;
+    write_bcd(out + length, hhmmss * 1000000 + time % 1000000, 6);
+    length += 6;
+
+    out[length++] = static_cast<uint8_t>((trade ? 0x80 : 0) | (bids << 4) | (asks << 1));
+    out[length++] = 0; // limit up / limit down
+    out[length++] = 0; // status
+    write_bcd(out + length, (odd_lot ? symbol.odd_volume : symbol.volume) % volume_modulus, volume_bytes);
+    length += volume_bytes;
+
+    auto write_level = [&](uint32_t price, uint32_t quantity) {
+        write_bcd(out + length, price, 5);
+        length += 5;
+        write_bcd(out + length, quantity, quantity_bytes);
+        length += quantity_bytes;
+    };
+    if (trade) write_level(symbol.price, trade_quantity);
+    for (uint32_t i = 0; i < bids; ++i) {
+        uint32_t step = symbol.tick * (i + 1);
+        write_level(symbol.price > step ? symbol.price - step : symbol.tick, 1 + uniform(odd_lot ? 999 : 500));
+    }
+    for (uint32_t i = 0; i < asks; ++i) {
+        write_level(symbol.price + symbol.tick * (i + 1), 1 + uniform(odd_lot ? 999 : 500));
+    }
+
+    return finish_message(out, length);
+}
+
+size_t FeedGenerator::write_warrant(uint8_t* out) {
+    size_t count = options.warrants == 0 ? 1 : options.warrants;
+    size_t warrant = next_warrant++ % count;
+    const GeneratedSymbol& underlying = symbols[warrant % symbols.size()];
+
+    size_t length = write_header(out, underlying.business_type, 0x14);
+
+    char text[24];
+    snprintf(text, sizeof(text), "%02zu%04zu", 3 + warrant / 10000, warrant % 10000);
+    pad_ascii(reinterpret_cast<char*>(out + length), 6, text);
+    length += 6;
+
+    char code[7] = {};
+    std::memcpy(code, underlying.code, 6);
+    for (int i = 5; i >= 0 && code[i] == ' '; --i) code[i] = '\0';
+    bool call = warrant % 3 != 2;
+    snprintf(text, sizeof(text), "%s%s%02zu", code, call ? "CALL" : "PUT", warrant % 100);
+    pad_ascii(reinterpret_cast<char*>(out + length), 16, text);      // Brief name
+    length += 16;
+    pad_ascii(reinterpret_cast<char*>(out + length), 2, "");         // Separator
+    length += 2;
+    pad_ascii(reinterpret_cast<char*>(out + length), 16, code);      // Underlying asset
+    length += 16;
+    snprintf(text, sizeof(text), "2027%02zu%02zu", 1 + warrant % 12, 1 + warrant % 28);
+    pad_ascii(reinterpret_cast<char*>(out + length), 8, text);       // Expiration date
+    length += 8;
+    pad_ascii(reinterpret_cast<char*>(out + length), 2, call ? "C" : "P");
+    length += 2;
+    pad_ascii(reinterpret_cast<char*>(out + length), 2, "A");
+    length += 2;
+    pad_ascii(reinterpret_cast<char*>(out + length), 2, "N");
+    length += 2;
+    pad_ascii(reinterpret_cast<char*>(out + length), 2, "");         // Reserved
+    length += 2;
+
+    return finish_message(out, length);
+}
@@ -0,0 +1,124 @@
+#include "framing.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FRAMING_HAVE_X86_KERNELS 1
+#endif
+
+size_t find_terminal_code(const uint8_t* data, size_t length) {
+    size_t i = 0;
+#ifdef FRAMING_HAVE_X86_KERNELS
+    const __m128i cr = _mm_set1_epi8(0x0D);
+    const __m128i lf = _mm_set1_epi8(0x0A);
+    // Compare data[i..i+15] against 0D and data[i+1..i+16] against 0A
+    for (; i + 17 <= length; i += 16) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, cr), _mm_cmpeq_epi8(second, lf)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i + 1 < length; ++i) {
+        if (data[i] == 0x0D && data[i + 1] == 0x0A) return i;
+    }
+    return length;
+}
+
+namespace {
+
+uint8_t xor_scalar(const uint8_t* data, size_t length) {
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < length; ++i) {
+        checksum ^= data[i];
+    }
+    return checksum;
+}
+
+#ifdef FRAMING_HAVE_X86_KERNELS
+
+// Fold a 16-byte accumulator down to one byte
+inline uint8_t fold_128(__m128i acc) {
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+    uint64_t folded = static_cast<uint64_t>(_mm_cvtsi128_si64(acc));
+    folded ^= folded >> 32;
+    folded ^= folded >> 16;
+    folded ^= folded >> 8;
+    return static_cast<uint8_t>(folded);
+}
+
+uint8_t xor_sse2(const uint8_t* data, size_t length) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+    return fold_128(acc) ^ xor_scalar(data + i, length - i);
+}
+
+__attribute__((target("avx2")))
+uint8_t xor_avx2(const uint8_t* data, size_t length) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+    }
+    __m128i folded = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    // Remaining 0..31 bytes
+    for (; i + 16 <= length; i += 16) {
+        folded = _mm_xor_si128(folded, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+    return fold_128(folded) ^ xor_scalar(data + i, length - i);
+}
+
+#endif // FRAMING_HAVE_X86_KERNELS
+
+using XorFunction = uint8_t (*)(const uint8_t*, size_t);
+
+XorFunction select_xor_kernel() {
+#ifdef FRAMING_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return xor_avx2;
+    return xor_sse2;
+#else
+    return xor_scalar;
+#endif
+}
+
+} // namespace
+
+uint8_t xor_checksum(const uint8_t* data, size_t length) {
+    static const XorFunction kernel = select_xor_kernel();
+    return kernel(data, length);
+}
+
+bool has_xor_kernel(XorKernel kernel) {
+    switch (kernel) {
+#ifdef FRAMING_HAVE_X86_KERNELS
+    case XorKernel::SSE2:
+        return true;
+    case XorKernel::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    case XorKernel::Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint8_t xor_checksum(XorKernel kernel, const uint8_t* data, size_t length) {
+    if (!has_xor_kernel(kernel)) return xor_scalar(data, length);
+    switch (kernel) {
+#ifdef FRAMING_HAVE_X86_KERNELS
+    case XorKernel::SSE2:
+        return xor_sse2(data, length);
+    case XorKernel::AVX2:
+        return xor_avx2(data, length);
+#endif
+    default:
+        return xor_scalar(data, length);
+    }
+}
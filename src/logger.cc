@@ -0,0 +1,292 @@
+#include "logger.h"
+#include "spsc_ring.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr size_t THREAD_RING_CAPACITY = 1024;
+constexpr size_t RATE_LIMIT_SLOTS = 64;
+
+uint64_t wall_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// FNV-1a over the level and the first bytes of the message, used as the rate-limit key
+uint64_t message_key(LogLevel level, const char* data, size_t length) {
+    uint64_t hash = 1469598103934665603ULL ^ static_cast<uint64_t>(level);
+    for (size_t i = 0; i < length && i < 32; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+    }
+    return hash | 1; // 0 marks an empty slot
+}
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "DEBUG: ";
+    case LogLevel::Info: return "INFO: ";
+    case LogLevel::Warning: return "WARNING: ";
+    case LogLevel::Error: return "ERROR: ";
+    default: return "";
+    }
+}
+
+} // namespace
+
+struct Logger::ThreadBuffer {
+    ThreadBuffer() : ring(THREAD_RING_CAPACITY) {}
+
+    SpscRing<LogRecord> ring;
+    std::atomic<bool> retired{false};
+
+    // Producer-side rate limiter state: one window per message key
+    struct RateSlot {
+        uint64_t key = 0;
+        uint64_t second = 0;
+        uint32_t count = 0;
+        uint32_t suppressed = 0;
+    };
+    RateSlot rate_slots[RATE_LIMIT_SLOTS];
+};
+
+namespace {
+
+// Marks the calling thread's ring as retired when the thread exits
+struct ThreadBufferHandle {
+    std::atomic<bool>* retired = nullptr;
+    void* buffer = nullptr;
+    ~ThreadBufferHandle() {
+        if (retired != nullptr) retired->store(true, std::memory_order_release);
+    }
+};
+
+thread_local ThreadBufferHandle thread_handle;
+
+} // namespace
+
+Logger::Logger() = default;
+
+void Logger::init(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(init_mutex);
+    if (initialized) return;
+
+    // Create logger directory if it doesn't exist
+    if (mkdir("logger", 0777) == -1) {
+        if (errno != EEXIST) {
+            std::cerr << "Error creating logger directory: " << strerror(errno) << std::endl;
+            return;
+        }
+    }
+
+    // Open log file in logger directory
+    std::string filepath = "logger/" + filename;
+    log_file.open(filepath, std::ios::out | std::ios::app);
+    if (!log_file.is_open()) {
+        std::cerr << "Error opening log file: " << filepath << std::endl;
+        return;
+    }
+
+    stopping = false;
+    initialized = true;
+    writer_thread = std::thread(&Logger::writer_loop, this);
+    log("Logger initialized: " + filepath);
+}
+
+void Logger::shutdown() {
+    std::lock_guard<std::mutex> lock(init_mutex);
+    if (!initialized) return;
+
+    stopping = true;
+    writer_thread.join();
+    initialized = false;
+    log_file.close();
+}
+
+Logger::~Logger() {
+    shutdown();
+}
+
+void Logger::log(const std::string& message, bool error) {
+    log(error ? LogLevel::Error : LogLevel::Info, message);
+}
+
+void Logger::log(LogLevel level, const std::string& message) {
+    if (!should_log(level)) return;
+    push(level, nullptr, 0, reinterpret_cast<const uint8_t*>(message.data()), message.size(), false);
+}
+
+void Logger::log(LogLevel level, const char* message) {
+    if (!should_log(level)) return;
+    push(level, nullptr, 0, reinterpret_cast<const uint8_t*>(message), strlen(message), false);
+}
+
+void Logger::log_bytes(LogLevel level, const char* label, const uint8_t* data, size_t length) {
+    if (!should_log(level)) return;
+    push(level, label, strlen(label), data, length, true);
+}
+
+Logger::ThreadBuffer* Logger::thread_buffer() {
+    if (thread_handle.buffer == nullptr) {
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+        thread_handle.retired = &buffer->retired;
+        thread_handle.buffer = buffer.get();
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(std::move(buffer));
+    }
+    return static_cast<ThreadBuffer*>(thread_handle.buffer);
+}
+
+void Logger::push(LogLevel level, const char* label, size_t label_length, const uint8_t* data, size_t length,
+                  bool is_bytes) {
+    ThreadBuffer* buffer = thread_buffer();
+    uint64_t now = wall_clock_ns();
+
+    // Rate limit repeats of the same message, per thread and per wall-clock second
+    uint32_t repeats = 0;
+    uint32_t limit = rate_limit.load(std::memory_order_relaxed);
+    if (limit != 0) {
+        const char* key_data = is_bytes ? label : reinterpret_cast<const char*>(data);
+        size_t key_length = is_bytes ? label_length : length;
+        uint64_t key = message_key(level, key_data, key_length);
+        ThreadBuffer::RateSlot& slot = buffer->rate_slots[key % RATE_LIMIT_SLOTS];
+        uint64_t second = now / 1000000000ULL;
+        if (slot.key != key || slot.second != second) {
+            repeats = slot.key == key ? slot.suppressed : 0;
+            slot.key = key;
+            slot.second = second;
+            slot.count = 0;
+            slot.suppressed = 0;
+        }
+        if (++slot.count > limit) {
+            slot.suppressed++;
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    LogRecord record;
+    record.timestamp_ns = now;
+    record.suppressed = repeats;
+    record.level = level;
+    record.is_bytes = is_bytes;
+    record.original_length = static_cast<uint16_t>(length > 0xFFFF ? 0xFFFF : length);
+
+    size_t used = 0;
+    if (is_bytes) {
+        used = label_length < 64 ? label_length : 64;
+        std::memcpy(record.data, label, used);
+    }
+    record.label_length = static_cast<uint16_t>(used);
+    size_t copy = length < sizeof(record.data) - used ? length : sizeof(record.data) - used;
+    std::memcpy(record.data + used, data, copy);
+    record.length = static_cast<uint16_t>(used + copy);
+
+    if (!buffer->ring.try_push(record)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::flush() {
+    if (!initialized) return;
+
+    // Wait for the rings to empty, then for one complete writer pass after that
+    while (true) {
+        bool empty = true;
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            for (const auto& buffer : buffers) {
+                if (buffer->ring.size() != 0) empty = false;
+            }
+        }
+        if (empty) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t pass = writer_passes.load(std::memory_order_acquire);
+    while (initialized && writer_passes.load(std::memory_order_acquire) < pass + 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::writer_loop() {
+    LogRecord record;
+    while (true) {
+        bool stop = stopping.load(std::memory_order_acquire);
+        size_t written = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            for (auto it = buffers.begin(); it != buffers.end();) {
+                ThreadBuffer& buffer = **it;
+                bool retired = buffer.retired.load(std::memory_order_acquire);
+                while (buffer.ring.try_pop(record)) {
+                    write_record(record);
+                    written++;
+                }
+                // The owning thread has exited and its ring is drained
+                it = retired ? buffers.erase(it) : it + 1;
+            }
+        }
+
+        if (written > 0) log_file.flush();
+        writer_passes.fetch_add(1, std::memory_order_release);
+
+        if (stop) break;
+        if (written == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::write_record(const LogRecord& record) {
+    int64_t second = static_cast<int64_t>(record.timestamp_ns / 1000000000ULL);
+    if (second != cached_second) {
+        time_t now_time_t = static_cast<time_t>(second);
+        std::tm tm_buf;
+        localtime_r(&now_time_t, &tm_buf);
+        strftime(cached_timestamp, sizeof(cached_timestamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+        cached_second = second;
+    }
+
+    char nanos[16];
+    snprintf(nanos, sizeof(nanos), ".%09llu", static_cast<unsigned long long>(record.timestamp_ns % 1000000000ULL));
+
+    std::string line;
+    line.reserve(64 + record.length * 3);
+    line += "[";
+    line += cached_timestamp;
+    line += nanos;
+    line += "] ";
+    line += level_name(record.level);
+
+    if (record.is_bytes) {
+        static const char digits[] = "0123456789abcdef";
+        line.append(record.data, record.label_length);
+        line += ":";
+        for (size_t i = record.label_length; i < record.length; ++i) {
+            uint8_t byte = static_cast<uint8_t>(record.data[i]);
+            line += ' ';
+            line += digits[byte >> 4];
+            line += digits[byte & 0x0F];
+        }
+    } else {
+        line.append(record.data, record.length);
+    }
+
+    size_t payload = record.length - record.label_length;
+    if (payload < record.original_length) {
+        line += " ... (" + std::to_string(record.original_length) + " bytes)";
+    }
+    if (record.suppressed > 0) {
+        line += " [" + std::to_string(record.suppressed) + " repeats suppressed]";
+    }
+
+    log_file << line << '\n';
+
+    if (record.level == LogLevel::Error) {
+        std::cerr << std::string(record.data + record.label_length, payload) << std::endl;
+    }
+}
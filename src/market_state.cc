@@ -0,0 +1,178 @@
+#include "market_state.h"
+#include "arbiter.h"
+#include "snapshot_store.h"
+#include "warrant_index.h"
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t PAGE = 4096;
+
+size_t page_align(size_t size) {
+    return (size + PAGE - 1) / PAGE * PAGE;
+}
+
+} // namespace
+
+MarketStateFile::~MarketStateFile() {
+    close();
+}
+
+bool MarketStateFile::open(const std::string& path, size_t snapshot_capacity, size_t warrant_capacity) {
+    close();
+
+    // Expected layout for these capacities
+    size_t sequence_offset = page_align(sizeof(MarketStateHeader));
+    size_t snapshot_offset = sequence_offset + page_align(MARKET_STATE_STREAMS * sizeof(std::atomic<uint32_t>));
+    size_t warrant_offset = snapshot_offset + page_align(SnapshotStore::memory_size(snapshot_capacity));
+    size_t size = warrant_offset + page_align(WarrantIndex::memory_size(warrant_capacity));
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = MAP_FAILED;
+    bool compatible = false;
+    if (static_cast<size_t>(st.st_size) == size) {
+        // Reattach only to a file written with exactly this layout
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            const MarketStateHeader* existing = static_cast<const MarketStateHeader*>(mapped);
+            compatible = existing->magic.load(std::memory_order_acquire) == MARKET_STATE_MAGIC &&
+                         existing->version == MARKET_STATE_VERSION &&
+                         existing->header_size == sizeof(MarketStateHeader) &&
+                         existing->snapshot_size == sizeof(BookSnapshot) &&
+                         existing->warrant_info_size == sizeof(WarrantInfo) &&
+                         existing->snapshot_capacity == snapshot_capacity &&
+                         existing->warrant_capacity == warrant_capacity &&
+                         existing->sequence_offset == sequence_offset &&
+                         existing->snapshot_offset == snapshot_offset &&
+                         existing->warrant_offset == warrant_offset &&
+                         existing->file_size == size;
+            if (!compatible) {
+                munmap(mapped, size);
+                mapped = MAP_FAILED;
+            }
+        }
+    }
+
+    if (!compatible) {
+        // Start over: truncating first zero-fills every table
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    base = static_cast<uint8_t*>(mapped);
+    mapping_size = size;
+    header = reinterpret_cast<MarketStateHeader*>(base);
+    sequences = reinterpret_cast<std::atomic<uint32_t>*>(base + sequence_offset);
+    attached = compatible;
+
+    if (compatible) {
+        unclean = header->clean.load(std::memory_order_relaxed) == 0;
+    } else {
+        new (header) MarketStateHeader;
+        header->version = MARKET_STATE_VERSION;
+        header->header_size = sizeof(MarketStateHeader);
+        header->snapshot_size = sizeof(BookSnapshot);
+        header->warrant_info_size = sizeof(WarrantInfo);
+        header->snapshot_capacity = snapshot_capacity;
+        header->warrant_capacity = warrant_capacity;
+        header->sequence_offset = sequence_offset;
+        header->snapshot_offset = snapshot_offset;
+        header->warrant_offset = warrant_offset;
+        header->file_size = size;
+        for (size_t i = 0; i < MARKET_STATE_STREAMS; ++i) {
+            new (&sequences[i]) std::atomic<uint32_t>(0);
+        }
+        unclean = false;
+    }
+    header->clean.store(0, std::memory_order_relaxed);
+    if (!compatible) {
+        // Only a fully initialised file carries the magic
+        header->magic.store(MARKET_STATE_MAGIC, std::memory_order_release);
+    }
+
+    saved.reset(new uint32_t[MARKET_STATE_STREAMS]);
+    first_seen.reset(new std::atomic<uint32_t>[MARKET_STATE_STREAMS]);
+    for (size_t i = 0; i < MARKET_STATE_STREAMS; ++i) {
+        saved[i] = sequences[i].load(std::memory_order_relaxed);
+        first_seen[i].store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void MarketStateFile::close() {
+    if (base == nullptr) return;
+    header->clean.store(1, std::memory_order_release);
+    msync(base, mapping_size, MS_SYNC);
+    munmap(base, mapping_size);
+    base = nullptr;
+    header = nullptr;
+    sequences = nullptr;
+    mapping_size = 0;
+}
+
+std::unique_ptr<SnapshotStore> MarketStateFile::make_snapshot_store() {
+    return std::unique_ptr<SnapshotStore>(
+        new SnapshotStore(header->snapshot_capacity, base + header->snapshot_offset, attached));
+}
+
+std::unique_ptr<WarrantIndex> MarketStateFile::make_warrant_index() {
+    return std::unique_ptr<WarrantIndex>(
+        new WarrantIndex(header->warrant_capacity, base + header->warrant_offset, attached));
+}
+
+bool MarketStateFile::record_sequence(uint8_t feed_id, uint8_t format_code, uint32_t sequence) {
+    size_t stream = (static_cast<size_t>(feed_id) << 8) | format_code;
+    bool first = first_seen[stream].load(std::memory_order_relaxed) == 0;
+    if (first) first_seen[stream].store(sequence + 1, std::memory_order_relaxed);
+
+    // Keep the newest position; a jump far back is a new session and replaces it
+    uint32_t current = sequences[stream].load(std::memory_order_relaxed);
+    if (current == 0 || sequence + 1 > current || sequence + LineArbiter::WINDOW < current) {
+        sequences[stream].store(sequence + 1, std::memory_order_relaxed);
+    }
+    return first && saved[stream] != 0;
+}
+
+StateCheck MarketStateFile::check(uint8_t feed_id, uint8_t format_code) const {
+    StateCheck result{};
+    if (base == nullptr) return result;
+    size_t stream = (static_cast<size_t>(feed_id) << 8) | format_code;
+    uint32_t saved_position = saved[stream];
+    uint32_t first_position = first_seen[stream].load(std::memory_order_relaxed);
+
+    result.reattached = saved_position != 0;
+    result.checked = first_position != 0;
+    if (!result.reattached || !result.checked) {
+        result.saved_sequence = saved_position != 0 ? saved_position - 1 : 0;
+        result.first_sequence = first_position != 0 ? first_position - 1 : 0;
+        return result;
+    }
+
+    result.saved_sequence = saved_position - 1;
+    result.first_sequence = first_position - 1;
+    if (result.first_sequence > result.saved_sequence + 1) {
+        result.missed = result.first_sequence - result.saved_sequence - 1;
+    } else if (result.first_sequence + LineArbiter::WINDOW < result.saved_sequence) {
+        // Small steps back are copies from the other line; a large one is a new session
+        result.session_restarted = true;
+    }
+    return result;
+}
@@ -0,0 +1,257 @@
+#include "parser.h"
+#include "receive_backend.h"
+#include <cstring>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <time.h>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 1 << 18;  // 256 KiB: fills quickly under load, so blocks retire before the timeout
+constexpr size_t MIN_BLOCKS = 4;
+constexpr size_t FRAME_SIZE = 2048;     // Holds a full Ethernet frame plus the TPACKET_V3 headers
+
+inline uint64_t wall_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Classic BPF over the IPv4 header (the socket is SOCK_DGRAM, so there is no
+// link-layer header): accept unfragmented UDP, or the first fragment, to one of
+// the ports, and drop everything else before it is copied into the ring.
+std::vector<struct sock_filter> udp_port_filter(const std::vector<uint16_t>& ports) {
+    size_t count = ports.size();
+    std::vector<struct sock_filter> code;
+    code.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9));                             // IP protocol
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, static_cast<uint8_t>(count + 4)));
+    code.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6));                             // Fragment offset
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, static_cast<uint8_t>(count + 2), 0));
+    code.push_back(BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0));                            // X = IP header length
+    code.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2));                             // UDP destination port
+    for (size_t i = 0; i < count; ++i) {
+        code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ports[i], static_cast<uint8_t>(count - i), 0));
+    }
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, 0));                                      // Drop
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, 0xFFFF));                                 // Accept the whole frame
+    return code;
+}
+
+} // namespace
+
+// Every subscription read from one TPACKET_V3 ring. The kernel fills blocks of
+// frames and hands a block over by setting TP_STATUS_USER; datagrams are parsed
+// straight from the mapped block, which is then returned to the kernel.
+class Parser::PacketRingBackend : public Parser::ReceiveBackend {
+public:
+    explicit PacketRingBackend(Parser& parser) : parser(parser) {}
+
+    ~PacketRingBackend() override {
+        if (fd >= 0) {
+            struct tpacket_stats_v3 stats{};
+            socklen_t length = sizeof(stats);
+            if (getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &stats, &length) == 0 && stats.tp_drops > 0) {
+                parser.log_message("Packet ring dropped " + std::to_string(stats.tp_drops) + " frames",
+                                   LogLevel::Warning);
+            }
+        }
+        if (ring != MAP_FAILED) munmap(ring, block_size * block_count);
+        if (fd >= 0) close(fd);
+        for (int member : members) close(member);
+    }
+
+    bool open(const std::vector<Subscription>& feeds, int epoll_fd) override {
+        this->feeds = feeds;
+        std::vector<uint16_t> ports;
+        for (const auto& feed : feeds) {
+            uint16_t port = static_cast<uint16_t>(feed.port);
+            bool known = false;
+            for (uint16_t seen : ports) known |= seen == port;
+            if (!known) ports.push_back(port);
+            groups.push_back(feed.multicast_group.empty() ? 0 : inet_addr(feed.multicast_group.c_str()));
+        }
+        if (ports.empty() || ports.size() > 250) {
+            parser.log_message("Packet ring needs between 1 and 250 distinct ports", LogLevel::Error);
+            return false;
+        }
+
+        // Protocol 0 receives nothing until bind(), so no frame slips in before the filter
+        fd = socket(AF_PACKET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            parser.log_message("Packet socket creation failed: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+        int version = TPACKET_V3;
+        if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+            parser.log_message("Failed to set TPACKET_V3: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+        std::vector<struct sock_filter> code = udp_port_filter(ports);
+        struct sock_fprog program{};
+        program.len = static_cast<unsigned short>(code.size());
+        program.filter = code.data();
+        if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) < 0) {
+            parser.log_message("Failed to attach the port filter: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+#ifdef PACKET_IGNORE_OUTGOING
+        // Datagrams sent from this host would otherwise show up a second time on loopback
+        int ignore = 1;
+        setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore, sizeof(ignore));
+#endif
+
+        block_size = BLOCK_SIZE;
+        block_count = std::max(MIN_BLOCKS, parser.packet_ring_size / block_size);
+        struct tpacket_req3 request{};
+        request.tp_block_size = static_cast<unsigned>(block_size);
+        request.tp_block_nr = static_cast<unsigned>(block_count);
+        request.tp_frame_size = FRAME_SIZE;
+        request.tp_frame_nr = static_cast<unsigned>(block_size / FRAME_SIZE * block_count);
+        request.tp_retire_blk_tov = static_cast<unsigned>(std::max(parser.packet_block_timeout_ms, 1));
+        if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) < 0) {
+            parser.log_message("Failed to set up the packet ring: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+        ring = mmap(nullptr, block_size * block_count, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        if (ring == MAP_FAILED) {
+            parser.log_message("Failed to map the packet ring: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+        struct sockaddr_ll address{};
+        address.sll_family = AF_PACKET;
+        address.sll_protocol = htons(ETH_P_IP);
+        if (!parser.packet_interface.empty()) {
+            address.sll_ifindex = static_cast<int>(if_nametoindex(parser.packet_interface.c_str()));
+            if (address.sll_ifindex == 0) {
+                parser.log_message("Unknown interface: " + parser.packet_interface, LogLevel::Error);
+                return false;
+            }
+        }
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+            parser.log_message("Packet socket bind failed: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+        // The ring sees frames on the wire, but the group still has to be joined for them to get there
+        for (const auto& feed : feeds) {
+            if (feed.multicast_group.empty()) continue;
+            int member = socket(AF_INET, SOCK_DGRAM, 0);
+            if (member < 0) continue;
+            members.push_back(member);
+            struct ip_mreq mreq{};
+            mreq.imr_multiaddr.s_addr = inet_addr(feed.multicast_group.c_str());
+            mreq.imr_interface.s_addr = inet_addr(feed.interface_ip.c_str());
+            if (setsockopt(member, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+                parser.log_message("Failed to join multicast group " + feed.multicast_group + ": " +
+                                   std::string(strerror(errno)), LogLevel::Error);
+            }
+        }
+
+        struct epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = 0;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            parser.log_message("epoll_ctl failed: " + std::string(strerror(errno)), LogLevel::Error);
+            return false;
+        }
+
+        std::stringstream ss;
+        ss << "Successfully initialized packet ring on "
+           << (parser.packet_interface.empty() ? std::string("all interfaces") : parser.packet_interface)
+           << " (" << block_count << " blocks of " << block_size << " bytes) for " << feeds.size()
+           << " subscriptions";
+        parser.log_message(ss.str());
+        return true;
+    }
+
+    // Walk every block the kernel has handed over, oldest first
+    void drain(uint32_t) override {
+        while (parser.running) {
+            auto* block = reinterpret_cast<struct tpacket_block_desc*>(static_cast<uint8_t*>(ring) +
+                                                                       current * block_size);
+            if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) return;
+
+            read_block(block);
+
+            __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+            current = (current + 1) % block_count;
+        }
+    }
+
+private:
+    void read_block(struct tpacket_block_desc* block) {
+        uint64_t batch_timestamp = parser.latency_stats && !parser.kernel_timestamps ? wall_clock_ns() : 0;
+        uint8_t* position = reinterpret_cast<uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+        for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; ++i) {
+            auto* frame = reinterpret_cast<struct tpacket3_hdr*>(position);
+            auto* link = reinterpret_cast<struct sockaddr_ll*>(position + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+            if (link->sll_pkttype != PACKET_OUTGOING) {
+                uint64_t timestamp = parser.kernel_timestamps
+                    ? static_cast<uint64_t>(frame->tp_sec) * 1000000000ULL + frame->tp_nsec
+                    : batch_timestamp;
+                read_frame(position + frame->tp_net, frame->tp_snaplen, timestamp);
+            }
+            position += frame->tp_next_offset;
+        }
+    }
+
+    // Strip the IPv4 and UDP headers and parse the payload where it lies
+    void read_frame(const uint8_t* ip, size_t length, uint64_t timestamp) {
+        if (length < 20 || (ip[0] >> 4) != 4) return;
+        size_t header_length = (ip[0] & 0x0F) * 4;
+        if (ip[9] != IPPROTO_UDP || length < header_length + 8) return;
+        if (((ip[6] << 8) | ip[7]) & 0x2000) {
+            // A first fragment; the rest of the datagram is not in this frame
+            parser.log_message("Dropped a fragmented datagram", LogLevel::Warning);
+            return;
+        }
+
+        uint32_t destination;
+        std::memcpy(&destination, ip + 16, sizeof(destination));
+        const uint8_t* udp = ip + header_length;
+        int port = (udp[2] << 8) | udp[3];
+        size_t payload_length = static_cast<size_t>((udp[4] << 8) | udp[5]);
+        if (payload_length < 8) return;
+        payload_length -= 8;
+        if (payload_length > length - header_length - 8) payload_length = length - header_length - 8;
+
+        for (size_t i = 0; i < feeds.size(); ++i) {
+            if (feeds[i].port != port || (groups[i] != 0 && groups[i] != destination)) continue;
+            ReceiveContext context{};
+            context.receive_timestamp_ns = timestamp;
+            context.feed_id = feeds[i].feed_id;
+            context.line_id = static_cast<uint8_t>(i);
+            parser.receive_datagram(udp + 8, payload_length, context);
+            return;
+        }
+    }
+
+    Parser& parser;
+    std::vector<Subscription> feeds;
+    std::vector<uint32_t> groups;  // Multicast group of each subscription (network order), 0 for any address
+    std::vector<int> members;      // Sockets holding the multicast memberships
+    int fd = -1;
+    void* ring = MAP_FAILED;
+    size_t block_size = 0;
+    size_t block_count = 0;
+    size_t current = 0;
+};
+
+std::unique_ptr<Parser::ReceiveBackend> Parser::make_packet_ring_backend() {
+    return std::unique_ptr<ReceiveBackend>(new PacketRingBackend(*this));
+}
@@ -1,12 +1,35 @@
 #include "parser.h"
+#include "bcd.h"
+#include "framing.h"
+#include "shm_ring.h"
+#include "receive_backend.h"
 #include <cstring>
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <sstream>
+#include <chrono>
 #include <algorithm>
 
+namespace {
+
+// Same clock as SO_TIMESTAMPNS, so kernel and user-space stamps compare directly
+inline uint64_t wall_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+} // namespace
+
 // Constructor
-Parser::Parser() : running(false), use_multicast(false) {
+Parser::Parser()
+    : running(false), use_multicast(false),
+      dispatch_table(&DefaultFormats::table), allowed_formats(DefaultFormats::bitmap) {
     // Initialize logger with timestamp in filename
     time_t now = time(nullptr);
     char timestamp[32];
@@ -22,14 +45,82 @@ Parser::~Parser() {
 
 // Start the UDP stream parsing loop in a new thread
 void Parser::start_loop(int port, const PacketCallback& callback) {
+    // The port passed here (with set_multicast settings) becomes feed 0
+    Subscription subscription;
+    subscription.feed_id = 0;
+    subscription.port = port;
+    if (use_multicast) {
+        subscription.multicast_group = multicast_group;
+        subscription.interface_ip = interface_ip;
+    }
+
+    std::vector<Subscription> all = subscriptions;
+    all.insert(all.begin(), subscription);
+    start_receiving(all, callback);
+}
+
+// Start the parsing loop over every subscription added with add_subscription
+void Parser::start_loop(const PacketCallback& callback) {
+    if (subscriptions.empty()) {
+        log_message("No subscriptions configured!", LogLevel::Error);
+        return;
+    }
+    start_receiving(subscriptions, callback);
+}
+
+void Parser::start_receiving(const std::vector<Subscription>& feeds, const PacketCallback& callback) {
     if (running) {
-        log_message("Parser is already running!", true);
+        log_message("Parser is already running!", LogLevel::Error);
+        return;
+    }
+
+    wakeup_fd = eventfd(0, EFD_NONBLOCK);
+    if (wakeup_fd < 0) {
+        log_message("eventfd creation failed: " + std::string(strerror(errno)), LogLevel::Error);
         return;
     }
 
+    if (!capture_path.empty()) {
+        capture_writer.reset(new CaptureWriter());
+        if (!capture_writer->open(capture_path)) {
+            log_message("Failed to open capture file: " + capture_path, LogLevel::Error);
+            capture_writer.reset();
+        }
+    }
+
+    open_tick_file();
+
+    if (!shm_name.empty()) {
+        shm_publisher.reset(new ShmPublisher());
+        if (!shm_publisher->open(shm_name, shm_capacity)) {
+            log_message("Failed to create shared-memory ring: " + shm_name, LogLevel::Error);
+            shm_publisher.reset();
+        }
+    }
+
+    if (!stats_file.empty() || stats_port > 0) {
+        stats_exporter.reset(new StatsExporter());
+        if (!stats_exporter->start([this] { return stats(); }, stats_file, stats_port, stats_interval_ms)) {
+            log_message("Failed to start stats export: " + std::string(strerror(errno)), LogLevel::Error);
+            stats_exporter.reset();
+        }
+    }
+
     running = true;
     packet_callback = callback;
-    recv_thread = std::thread(&Parser::receive_loop, this, port);
+    arbiter.reset();
+
+    if (dispatch_mode != DispatchMode::Inline) {
+        packet_ring.reset(new SpscRing<Packet>(ring_capacity));
+        ring_high_water = 0;
+        ring_drops = 0;
+        if (dispatch_mode == DispatchMode::Thread) {
+            dispatching = true;
+            dispatch_thread = std::thread(&Parser::dispatch_loop, this);
+        }
+    }
+
+    recv_thread = std::thread(&Parser::receive_loop, this, feeds);
 }
 
 // Stop the parsing loop and clean up resources
@@ -38,109 +129,370 @@ void Parser::end_loop() {
 
     running = false;
     if (recv_thread.joinable()) {
-        if (sockfd != -1) {
-            shutdown(sockfd, SHUT_RDWR);
-            close(sockfd);
+        // Wake the receive thread out of epoll_wait
+        uint64_t one = 1;
+        if (write(wakeup_fd, &one, sizeof(one)) < 0) {
+            log_message("Failed to wake receive thread: " + std::string(strerror(errno)), LogLevel::Error);
         }
         recv_thread.join();
     }
+    close(wakeup_fd);
+    wakeup_fd = -1;
+
+    // Flush the capture file once the receive thread can no longer append
+    if (capture_writer) {
+        capture_writer->close();
+        capture_writer.reset();
+    }
+    flush_tick_batch();
+    close_tick_file();
+    flush_bars();
+    shm_publisher.reset();
+
+    // The dispatch thread drains whatever the receive thread queued before exiting
+    dispatching = false;
+    if (dispatch_thread.joinable()) {
+        dispatch_thread.join();
+    }
+
+    // Writes the final values on the way out
+    stats_exporter.reset();
 }
 
-// Receive UDP packets and feed them into the parser
-void Parser::receive_loop(int port) {
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        log_message("Socket creation failed: " + std::string(strerror(errno)), true);
-        return;
+// Subscribe to one more (port, multicast group, interface); packets are tagged with feed_id
+void Parser::add_subscription(uint8_t feed_id, int port, const std::string& group, const std::string& iface) {
+    Subscription subscription;
+    subscription.feed_id = feed_id;
+    subscription.port = port;
+    subscription.multicast_group = group;
+    subscription.interface_ip = iface;
+    subscriptions.push_back(subscription);
+}
+
+// Create, bind and (optionally) join the multicast group for one subscription
+int Parser::open_socket(const Subscription& subscription) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        log_message("Socket creation failed: " + std::string(strerror(errno)), LogLevel::Error);
+        return -1;
     }
 
     // Enable SO_REUSEADDR
     int reuse = 1;
-    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
-        log_message("Failed to set SO_REUSEADDR: " + std::string(strerror(errno)), true);
-        close(sockfd);
-        return;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+        log_message("Failed to set SO_REUSEADDR: " + std::string(strerror(errno)), LogLevel::Error);
+        close(fd);
+        return -1;
+    }
+
+    if (kernel_timestamps) {
+        int enable = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+            log_message("Failed to set SO_TIMESTAMPNS: " + std::string(strerror(errno)), LogLevel::Error);
+        }
+    }
+
+    if (receive_buffer_size > 0) {
+        // SO_RCVBUFFORCE ignores rmem_max but needs CAP_NET_ADMIN
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &receive_buffer_size, sizeof(receive_buffer_size)) < 0 &&
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer_size, sizeof(receive_buffer_size)) < 0) {
+            log_message("Failed to set SO_RCVBUF: " + std::string(strerror(errno)), LogLevel::Error);
+        }
+        int actual = 0;
+        socklen_t actual_length = sizeof(actual);
+        getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &actual, &actual_length);
+        // The kernel reports double the requested size to account for its bookkeeping
+        if (actual / 2 < receive_buffer_size) {
+            log_message("Receive buffer is " + std::to_string(actual / 2) + " bytes, not " +
+                        std::to_string(receive_buffer_size) + "; raise net.core.rmem_max", LogLevel::Warning);
+        }
+    }
+
+#ifdef SO_BUSY_POLL
+    if (busy_poll_us > 0) {
+        if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us)) < 0) {
+            log_message("Failed to set SO_BUSY_POLL: " + std::string(strerror(errno)), LogLevel::Error);
+        }
     }
+#endif
 
     sockaddr_in server_addr{};
     server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
+    server_addr.sin_port = htons(subscription.port);
     server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    
+
     // Bind to the port
-    if (bind(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        log_message("Bind failed: " + std::string(strerror(errno)), true);
-        close(sockfd);
-        return;
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        log_message("Bind failed: " + std::string(strerror(errno)), LogLevel::Error);
+        close(fd);
+        return -1;
     }
 
-    if (use_multicast) {
+    bool multicast = !subscription.multicast_group.empty();
+    if (multicast) {
         // Set up multicast request
         struct ip_mreq mreq{};
-        mreq.imr_multiaddr.s_addr = inet_addr(multicast_group.c_str());
-        mreq.imr_interface.s_addr = inet_addr(interface_ip.c_str());
+        mreq.imr_multiaddr.s_addr = inet_addr(subscription.multicast_group.c_str());
+        mreq.imr_interface.s_addr = inet_addr(subscription.interface_ip.c_str());
 
         std::stringstream ss;
-        ss << "Attempting to join multicast group " << multicast_group 
-           << " on interface " << interface_ip;
+        ss << "Attempting to join multicast group " << subscription.multicast_group
+           << " on interface " << subscription.interface_ip;
         log_message(ss.str());
 
-        if (setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
-            log_message("Failed to join multicast group: " + std::string(strerror(errno)), true);
-            close(sockfd);
-            return;
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            log_message("Failed to join multicast group: " + std::string(strerror(errno)), LogLevel::Error);
+            close(fd);
+            return -1;
         }
 
         // Set multicast interface
         struct in_addr local_interface{};
-        local_interface.s_addr = inet_addr(interface_ip.c_str());
-        if (setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_IF, &local_interface, sizeof(local_interface)) < 0) {
-            log_message("Failed to set multicast interface: " + std::string(strerror(errno)), true);
-            close(sockfd);
-            return;
+        local_interface.s_addr = inet_addr(subscription.interface_ip.c_str());
+        if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &local_interface, sizeof(local_interface)) < 0) {
+            log_message("Failed to set multicast interface: " + std::string(strerror(errno)), LogLevel::Error);
+            close(fd);
+            return -1;
+        }
+
+#ifdef IP_MULTICAST_ALL
+        // Only deliver the group joined on this socket, not every group joined on the port
+        int multicast_all = 0;
+        if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_ALL, &multicast_all, sizeof(multicast_all)) < 0) {
+            log_message("Failed to clear IP_MULTICAST_ALL: " + std::string(strerror(errno)), LogLevel::Error);
         }
+#endif
     }
 
     std::stringstream init_ss;
-    init_ss << "Successfully initialized socket on port " << port;
-    if (use_multicast) {
-        init_ss << " (multicast group: " << multicast_group 
-                << ", interface: " << interface_ip << ")";
+    init_ss << "Successfully initialized socket on port " << subscription.port
+            << " for feed " << static_cast<int>(subscription.feed_id);
+    if (multicast) {
+        init_ss << " (multicast group: " << subscription.multicast_group
+                << ", interface: " << subscription.interface_ip << ")";
     }
     log_message(init_ss.str());
 
-    char buffer[1500]; // Maximum UDP packet size
+    return fd;
+}
+
+// Preallocated receive buffers shared by every socket of the loop
+struct Parser::ReceiveBuffers {
+    explicit ReceiveBuffers(size_t count)
+        : count(count),
+          data(count * MAX_DATAGRAM_SIZE),
+          controls(count * CMSG_SPACE(sizeof(struct timespec))),
+          iovecs(count),
+          messages(count) {
+        for (size_t i = 0; i < count; ++i) {
+            iovecs[i].iov_base = data.data() + i * MAX_DATAGRAM_SIZE;
+            iovecs[i].iov_len = MAX_DATAGRAM_SIZE;
+        }
+    }
+
+    size_t count;
+    std::vector<uint8_t> data;
+    std::vector<char> controls;
+    std::vector<struct iovec> iovecs;
+    std::vector<struct mmsghdr> messages;
+};
+
+// One non-blocking UDP socket per subscription, read with recv() or recvmmsg()
+class Parser::SocketBackend : public Parser::ReceiveBackend {
+public:
+    explicit SocketBackend(Parser& parser) : parser(parser), buffers(std::max<size_t>(parser.batch_size, 1)) {}
 
+    ~SocketBackend() override {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    bool open(const std::vector<Subscription>& feeds, int epoll_fd) override {
+        this->feeds = feeds;
+        bool opened = false;
+        for (size_t i = 0; i < feeds.size(); ++i) {
+            int fd = parser.open_socket(feeds[i]);
+            fds.push_back(fd);
+            if (fd < 0) continue;
+            opened = true;
+
+            struct epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u32 = static_cast<uint32_t>(i);
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                parser.log_message("epoll_ctl failed: " + std::string(strerror(errno)), LogLevel::Error);
+            }
+        }
+        return opened;
+    }
+
+    void drain(uint32_t index) override {
+        ReceiveContext context{};
+        context.feed_id = feeds[index].feed_id;
+        context.line_id = static_cast<uint8_t>(index);
+        parser.drain_socket(fds[index], context, buffers);
+    }
+
+private:
+    Parser& parser;
+    std::vector<Subscription> feeds;
+    std::vector<int> fds;
+    ReceiveBuffers buffers; // Allocated before the first datagram arrives
+};
+
+// Service every source of the ingest backend from one epoll loop
+void Parser::receive_loop(std::vector<Subscription> feeds) {
+    configure_thread(receive_cpu, "receive");
+
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        log_message("epoll creation failed: " + std::string(strerror(errno)), LogLevel::Error);
+        return;
+    }
+
+    struct epoll_event wake_event{};
+    wake_event.events = EPOLLIN;
+    wake_event.data.u32 = UINT32_MAX;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &wake_event);
+
+    std::unique_ptr<ReceiveBackend> backend;
+    if (ingest_backend == IngestBackend::PacketMmap) {
+        backend = make_packet_ring_backend();
+    } else {
+        backend.reset(new SocketBackend(*this));
+    }
+    if (!backend->open(feeds, epoll_fd)) {
+        log_message("No source could be opened", LogLevel::Error);
+        backend.reset();
+        close(epoll_fd);
+        return;
+    }
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+
+    // Busy polling never sleeps in the kernel, so there is no wakeup to wait for
+    int timeout = busy_poll ? 0 : -1;
     while (running) {
-        ssize_t len = recv(sockfd, buffer, sizeof(buffer), 0);
-        if (len > 0) {
-            std::vector<uint8_t> raw_packet(buffer, buffer + len);
-            
-            // Split packets by 0D 0A delimiter
-            size_t start_pos = 0;
-            for (size_t i = 0; i < raw_packet.size() - 1; i++) {
-                if (raw_packet[i] == 0x0D && raw_packet[i + 1] == 0x0A) {
-                    // Found a complete packet
-                    size_t packet_length = i + 2 - start_pos;  // Including 0D 0A
-                    std::vector<uint8_t> single_packet(raw_packet.begin() + start_pos, 
-                                                     raw_packet.begin() + start_pos + packet_length);
-                    
-                    // Process single packet
-                    parse_packet(single_packet);
-                    
-                    // Update start position for next packet
-                    start_pos = i + 2;
+        int ready = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            log_message("epoll_wait failed: " + std::string(strerror(errno)), LogLevel::Error);
+            break;
+        }
+
+        for (int i = 0; i < ready && running; ++i) {
+            uint32_t index = events[i].data.u32;
+            if (index == UINT32_MAX) continue; // woken up by end_loop
+            backend->drain(index);
+        }
+    }
+
+    backend.reset();
+    close(epoll_fd);
+}
+
+// Count, capture and parse a datagram in place
+void Parser::receive_datagram(const uint8_t* data, size_t length, const ReceiveContext& context) {
+    bump(metrics.datagrams_received);
+    bump(metrics.bytes_received, length);
+    if (capture_writer) {
+        capture_writer->append(context.receive_timestamp_ns, context.feed_id, context.line_id, data, length);
+    }
+    parse_datagram(data, length, context);
+}
+
+// Read everything currently queued on a non-blocking socket
+void Parser::drain_socket(int fd, ReceiveContext& context, ReceiveBuffers& buffers) {
+    if (buffers.count == 1 && !kernel_timestamps) {
+        uint8_t* buffer = buffers.data.data();
+        while (running) {
+            ssize_t len = recv(fd, buffer, MAX_DATAGRAM_SIZE, 0);
+            if (len < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    log_message("Error receiving data: " + std::string(strerror(errno)), LogLevel::Error);
                 }
+                return;
             }
-        } else if (len < 0) {
-            if (errno != EINTR && errno != EBADF) {  // ignore EINTR and EBADF
-                log_message("Error receiving data: " + std::string(strerror(errno)), true);
+            if (latency_stats) context.receive_timestamp_ns = wall_clock_ns();
+            receive_datagram(buffer, static_cast<size_t>(len), context);
+        }
+        return;
+    }
+
+    // Drain up to buffers.count datagrams per recvmmsg() call
+    while (running) {
+        // recvmmsg overwrites msg_controllen, so the headers are reset before every call
+        for (size_t i = 0; i < buffers.count; ++i) {
+            struct mmsghdr& message = buffers.messages[i];
+            std::memset(&message, 0, sizeof(message));
+            message.msg_hdr.msg_iov = &buffers.iovecs[i];
+            message.msg_hdr.msg_iovlen = 1;
+            if (kernel_timestamps) {
+                message.msg_hdr.msg_control = buffers.controls.data() + i * CMSG_SPACE(sizeof(struct timespec));
+                message.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(struct timespec));
             }
-            break;
         }
+
+        int received = recvmmsg(fd, buffers.messages.data(), buffers.count, 0, nullptr);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                log_message("Error receiving data: " + std::string(strerror(errno)), LogLevel::Error);
+            }
+            return;
+        }
+
+        uint64_t batch_timestamp = latency_stats && !kernel_timestamps ? wall_clock_ns() : 0;
+        for (int i = 0; i < received; ++i) {
+            struct mmsghdr& message = buffers.messages[i];
+            context.receive_timestamp_ns = batch_timestamp;
+            if (kernel_timestamps) {
+                for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message.msg_hdr); cmsg != nullptr;
+                     cmsg = CMSG_NXTHDR(&message.msg_hdr, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                        struct timespec ts;
+                        std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                        context.receive_timestamp_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+                    }
+                }
+            }
+            receive_datagram(static_cast<const uint8_t*>(buffers.iovecs[i].iov_base), message.msg_len, context);
+        }
+
+        // A short batch means the socket queue is empty
+        if (static_cast<size_t>(received) < buffers.count) return;
     }
 }
 
+// Messages are framed by the message_length header field; the 0D 0A delimiter
+// search is only a fallback to resynchronise after a malformed message, since
+// BCD price data may itself contain 0D 0A.
+void Parser::parse_datagram(const uint8_t* data, size_t length, const ReceiveContext& context) {
+    size_t start_pos = 0;
+    while (start_pos + TERMINAL_CODE_SIZE <= length) {
+        const uint8_t* message = data + start_pos;
+        size_t remaining = length - start_pos;
+
+        if (remaining > 1 + HEADER_LENGTH && message[0] == ESC_CODE) {
+            size_t message_length = bcd_to_binary((message[1] << 8) | message[2]);
+            if (message_length > 1 + HEADER_LENGTH + TERMINAL_CODE_SIZE &&
+                message_length <= remaining &&
+                message[message_length - 2] == 0x0D && message[message_length - 1] == 0x0A) {
+                parse_packet(message, message_length, context);
+                start_pos += message_length;
+                continue;
+            }
+        }
+
+        // Resync: hand everything up to the next 0D 0A to the parser
+        size_t terminal = find_terminal_code(message, remaining);
+        if (terminal == remaining) break;
+        parse_packet(message, terminal + TERMINAL_CODE_SIZE, context);
+        start_pos += terminal + TERMINAL_CODE_SIZE;
+    }
+    flush_inline_batch();
+}
+
 // Add a new method to configure multicast
 void Parser::set_multicast(const std::string& group, const std::string& iface) {
     multicast_group = group;
@@ -148,109 +500,740 @@ void Parser::set_multicast(const std::string& group, const std::string& iface) {
     use_multicast = true;
 }
 
-int hexStringToInt(const std::string& hex_str) {
+// Receive datagrams in batches of up to batch_size per syscall
+void Parser::set_batch_receive(size_t size) {
+    batch_size = size;
+}
+
+// Attach the kernel receive timestamp (SO_TIMESTAMPNS) to every packet
+void Parser::set_kernel_timestamps(bool enable) {
+    kernel_timestamps = enable;
+}
+
+// Thread placement and socket tuning; all take effect on the next start_loop
+void Parser::set_cpu_affinity(int receive_cpu, int dispatch_cpu) {
+    this->receive_cpu = receive_cpu;
+    this->dispatch_cpu = dispatch_cpu;
+}
+
+void Parser::set_realtime_priority(int priority) {
+    realtime_priority = priority;
+}
+
+void Parser::set_busy_poll(bool enable, int busy_poll_us) {
+    busy_poll = enable;
+    this->busy_poll_us = busy_poll_us;
+}
+
+void Parser::set_receive_buffer_size(int bytes) {
+    receive_buffer_size = bytes;
+}
+
+void Parser::set_ingest_backend(IngestBackend backend, const std::string& interface, size_t ring_size,
+                                int block_timeout_ms) {
+    ingest_backend = backend;
+    packet_interface = interface;
+    packet_ring_size = ring_size;
+    packet_block_timeout_ms = block_timeout_ms;
+}
+
+void Parser::configure_thread(int cpu, const char* role) {
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (error != 0) {
+            log_message("Failed to pin " + std::string(role) + " thread to CPU " + std::to_string(cpu) + ": " +
+                        strerror(error), LogLevel::Error);
+        }
+    }
+
+    if (realtime_priority > 0) {
+        struct sched_param param{};
+        param.sched_priority = realtime_priority;
+        int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error != 0) {
+            log_message("Failed to set SCHED_FIFO for " + std::string(role) + " thread: " + strerror(error),
+                        LogLevel::Error);
+        }
+    }
+}
+
+// Configure decoupled dispatch; takes effect on the next start_loop
+void Parser::set_dispatch_mode(DispatchMode mode, size_t capacity, BackpressurePolicy policy) {
+    dispatch_mode = mode;
+    ring_capacity = capacity;
+    backpressure_policy = policy;
+}
+
+// Deliver queued packets on the calling thread
+size_t Parser::poll(size_t max_packets) {
+    if (!packet_ring || dispatch_mode != DispatchMode::Poll) return 0;
+
+    if (batch_callback) {
+        size_t limit = std::min(max_packets, batch_buffer.size());
+        size_t count = 0;
+        while (count < limit && packet_ring->try_pop(batch_buffer[count])) {
+            count++;
+        }
+        if (count > 0) invoke_batch_callback(batch_buffer.data(), count);
+        return count;
+    }
+
+    size_t delivered = 0;
+    Packet packet;
+    while (delivered < max_packets && packet_ring->try_pop(packet)) {
+        invoke_callback(packet);
+        delivered++;
+    }
+    return delivered;
+}
+
+void Parser::set_batch_callback(size_t max_batch, const PacketBatchCallback& callback) {
+    if (running) {
+        log_message("Cannot change the callback while the parser is running!", LogLevel::Error);
+        return;
+    }
+    this->max_batch = max_batch == 0 ? 1 : max_batch;
+    batch_callback = callback;
+    // Reused by poll() and by inline delivery, so neither allocates per call
+    batch_buffer.assign(batch_callback ? this->max_batch : 0, Packet{});
+    batch_pending = 0;
+}
+
+// Drain the ring straight into the caller's buffer; spin briefly, then sleep, while it is empty
+size_t Parser::poll_batch(Packet* out, size_t max_packets, int timeout_ms) {
+    if (!packet_ring || dispatch_mode != DispatchMode::Poll || max_packets == 0) return 0;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    size_t count = 0;
+    for (unsigned spins = 0; ; ++spins) {
+        while (count < max_packets && packet_ring->try_pop(out[count])) {
+            count++;
+        }
+        if (count > 0 || timeout_ms == 0 || !running) break;
+        if (timeout_ms > 0 && std::chrono::steady_clock::now() >= deadline) break;
+
+        if (spins < 1000) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    if (latency_stats && count > 0) record_handoff_latency(out, count, wall_clock_ns());
+    return count;
+}
+
+uint64_t Parser::get_ring_high_water() const {
+    return ring_high_water.load(std::memory_order_relaxed);
+}
+
+uint64_t Parser::get_ring_drops() const {
+    return ring_drops.load(std::memory_order_relaxed);
+}
+
+// Record every raw datagram to an append-only capture file while the loop runs
+void Parser::set_capture_file(const std::string& path) {
+    capture_path = path;
+}
+
+uint64_t Parser::get_capture_drops() const {
+    return capture_writer ? capture_writer->get_dropped() : 0;
+}
+
+// Feed a capture file through the same parse path as live datagrams, on the calling thread
+bool Parser::replay(const std::string& path, const PacketCallback& callback, bool paced) {
+    if (running) {
+        log_message("Cannot replay while the parser is running!", LogLevel::Error);
+        return false;
+    }
+
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        log_message("Failed to open capture file: " + path, LogLevel::Error);
+        return false;
+    }
+
+    // Replay always delivers inline
+    packet_callback = callback;
+    packet_ring.reset();
+    arbiter.reset();
+    open_tick_file();
+
+    // Recorded timestamps are historical, so they say nothing about callback latency
+    bool measure_latency = latency_stats;
+    latency_stats = false;
+
+    CaptureRecord record;
+    uint64_t first_timestamp = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.next(record)) {
+        if (paced) {
+            // Reproduce the original spacing between datagrams
+            if (first_timestamp == 0) first_timestamp = record.timestamp_ns;
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.timestamp_ns - first_timestamp));
+        }
+
+        ReceiveContext context{};
+        context.receive_timestamp_ns = record.timestamp_ns;
+        context.feed_id = record.feed_id;
+        context.line_id = record.line_id;
+        parse_datagram(record.data, record.length, context);
+    }
+
+    flush_tick_batch();
+    close_tick_file();
+    flush_bars();
+    latency_stats = measure_latency;
+    return true;
+}
+
+void Parser::set_packet_callback(const PacketCallback& callback) {
+    if (running) {
+        log_message("Cannot change the callback while the parser is running!", LogLevel::Error);
+        return;
+    }
+    packet_callback = callback;
+    packet_ring.reset();
+}
+
+void Parser::parse_buffer(const uint8_t* data, size_t length, uint64_t receive_timestamp_ns,
+                          uint8_t feed_id, uint8_t line_id) {
+    ReceiveContext context{};
+    context.receive_timestamp_ns = receive_timestamp_ns;
+    context.feed_id = feed_id;
+    context.line_id = line_id;
+    parse_datagram(data, length, context);
+}
+
+void Parser::set_decode_bcd(bool enable) {
+    decode_bcd = enable;
+}
+
+// Enable A/B arbitration; takes effect immediately, state is reset on every start
+void Parser::set_arbitration(bool enable) {
+    arbitration_enabled = enable;
+}
+
+void Parser::set_gap_callback(const GapCallback& callback) {
+    arbiter.set_gap_callback(callback);
+}
+
+ArbitrationStats Parser::get_arbitration_stats(uint8_t feed_id) const {
+    return arbiter.stats(feed_id);
+}
+
+void Parser::set_tick_batches(size_t rows, const TickBatchCallback& callback) {
+    tick_batch_rows = rows;
+    tick_callback = callback;
+    tick_batch.reset();
+}
+
+void Parser::set_tick_file(const std::string& path, size_t rows) {
+    tick_file_path = path;
+    if (tick_batch_rows == 0) tick_batch_rows = rows;
+}
+
+void Parser::flush_tick_batch() {
+    if (running) {
+        log_message("Cannot flush the tick batch while the parser is running!", LogLevel::Error);
+        return;
+    }
+    hand_over_tick_batch();
+}
+
+// Receive thread, or any thread once it has stopped
+void Parser::hand_over_tick_batch() {
+    if (!tick_batch || tick_batch->size() == 0) return;
+
+    // A new batch is allocated for the next rows; consumers keep theirs as long as they like
+    std::shared_ptr<TickBatch> batch = std::move(tick_batch);
+    tick_batch.reset();
+    if (tick_writer) tick_writer->write(batch);
+    if (tick_callback) tick_callback(batch);
+}
+
+void Parser::open_tick_file() {
+    if (tick_file_path.empty() || tick_writer) return;
+    tick_writer.reset(new TickFileWriter());
+    if (!tick_writer->open(tick_file_path)) {
+        log_message("Failed to open tick file: " + tick_file_path, LogLevel::Error);
+        tick_writer.reset();
+    }
+}
+
+void Parser::close_tick_file() {
+    if (tick_writer) {
+        tick_writer->close();
+        tick_writer.reset();
+    }
+}
+
+void Parser::set_shm_publisher(const std::string& name, size_t capacity) {
+    shm_name = name;
+    shm_capacity = capacity;
+}
+
+void Parser::enable_snapshot_store(size_t capacity) {
+    snapshot_store.reset(new SnapshotStore(capacity));
+}
+
+bool Parser::get_snapshot(const std::string& stock_code, BookSnapshot& out, uint8_t format_code) const {
+    return snapshot_store && snapshot_store->lookup(stock_code, out, format_code);
+}
+
+const SnapshotStore* Parser::get_snapshot_store() const {
+    return snapshot_store.get();
+}
+
+void Parser::enable_warrant_index(size_t capacity) {
+    warrant_index.reset(new WarrantIndex(capacity));
+}
+
+bool Parser::get_warrant(const std::string& warrant_code, WarrantInfo& out) const {
+    return warrant_index && warrant_index->lookup(warrant_code, out);
+}
+
+std::vector<WarrantInfo> Parser::get_warrants_on(const std::string& underlying) const {
+    if (!warrant_index) return {};
+    return warrant_index->warrants_on(underlying);
+}
+
+const WarrantIndex* Parser::get_warrant_index() const {
+    return warrant_index.get();
+}
+
+bool Parser::set_state_file(const std::string& path, size_t snapshot_capacity, size_t warrant_capacity) {
+    // The stores may live in the previous file, so they go first
+    snapshot_store.reset();
+    warrant_index.reset();
+    state_file.reset(new MarketStateFile());
+    if (!state_file->open(path, snapshot_capacity, warrant_capacity)) {
+        log_message("Failed to open state file " + path + ": " + std::string(strerror(errno)), LogLevel::Error);
+        state_file.reset();
+        return false;
+    }
+    snapshot_store = state_file->make_snapshot_store();
+    warrant_index = state_file->make_warrant_index();
+
     std::stringstream ss;
-    ss << std::hex << hex_str;
+    if (state_file->reattached()) {
+        ss << "Reattached state file " << path << " with " << snapshot_store->size() << " books and "
+           << warrant_index->size() << " warrants";
+        if (state_file->recovered_from_crash()) ss << " (previous writer did not close it)";
+    } else {
+        ss << "Created state file " << path;
+    }
+    log_message(ss.str(), LogLevel::Info);
+    return state_file->reattached();
+}
 
-    int value;
-    ss >> value;
+StateCheck Parser::get_state_check(uint8_t feed_id, uint8_t format_code) const {
+    if (!state_file) return StateCheck{};
+    return state_file->check(feed_id, format_code);
+}
+
+// Track the stream position in the state file, and check the first message after reattaching against it
+void Parser::record_state_sequence(const Packet& packet) {
+    uint32_t sequence = static_cast<uint32_t>(bcd_to_binary(packet.transmission_number));
+    if (!state_file->record_sequence(packet.feed_id, packet.format_code, sequence)) return;
 
-    if (ss.fail() && !ss.eof()) {
-        throw std::runtime_error("Invalid hex string: " + hex_str);
+    StateCheck check = state_file->check(packet.feed_id, packet.format_code);
+    std::stringstream ss;
+    ss << "State for feed " << static_cast<int>(packet.feed_id) << " format 0x" << std::hex
+       << static_cast<int>(packet.format_code) << std::dec << " saved at " << check.saved_sequence
+       << ", feed at " << check.first_sequence;
+    if (check.session_restarted) {
+        ss << ": state is from an earlier session";
+        log_message(ss.str(), LogLevel::Warning);
+    } else if (check.missed > 0) {
+        ss << ": " << check.missed << " messages missed while down";
+        log_message(ss.str(), LogLevel::Warning);
+    } else {
+        ss << ": state is current";
+        log_message(ss.str(), LogLevel::Info);
     }
+}
+
+void Parser::enable_bars(const std::vector<uint32_t>& intervals_ms, size_t capacity) {
+    bar_engine.reset(new BarEngine(intervals_ms, capacity));
+    bar_engine->set_callback(bar_callback);
+}
+
+void Parser::set_bar_callback(const BarCallback& callback) {
+    bar_callback = callback;
+    if (bar_engine) bar_engine->set_callback(callback);
+}
 
-    return value;
+size_t Parser::poll_bars(Bar* out, size_t max_bars) {
+    return bar_engine ? bar_engine->poll(out, max_bars) : 0;
+}
+
+// The engine has a single writer, the receive thread, so only flush once it has stopped
+void Parser::flush_bars() {
+    if (running) {
+        log_message("Cannot flush bars while the parser is running!", LogLevel::Error);
+        return;
+    }
+    if (bar_engine) bar_engine->flush();
+}
+
+uint64_t Parser::get_bar_drops() const {
+    return bar_engine ? bar_engine->get_dropped() : 0;
 }
 
 // Add a new method to set allowed format codes
 void Parser::set_allowed_format_codes(const std::vector<uint8_t>& codes) {
-    // Store the codes verbatim (the API expects numeric format codes)
+    // The first call replaces the default "accept everything" filter
+    if (!format_filter_set) {
+        allowed_formats = FormatBitmap{};
+        format_filter_set = true;
+    }
+
+    // Codes are given as the decimal digits of the BCD format code, so 23 selects 0x23
     for (const auto& code : codes) {
-        allowed_format_codes.push_back(hexStringToInt(std::to_string(code)));
+        allowed_formats.set(static_cast<uint8_t>(((code / 10) % 10) << 4 | (code % 10)));
     }
     std::stringstream ss;
     ss << "C++: Received allowed format codes (hex): [ ";
-    for (const auto& code : allowed_format_codes) {
-        ss << std::hex << static_cast<int>(code) << " ";
+    for (int code = 0; code < 256; ++code) {
+        if (allowed_formats.test(static_cast<uint8_t>(code))) {
+            ss << std::hex << code << " ";
+        }
     }
     ss << "]";
     log_message(ss.str());
 }
 
+void Parser::set_symbol_filter(const std::vector<std::string>& stock_codes) {
+    symbol_filter = SymbolSet(stock_codes);
+    log_message("C++: Symbol filter set to " + std::to_string(symbol_filter.size()) + " stock codes");
+}
+
 // Parse the received packet
-void Parser::parse_packet(const std::vector<uint8_t>& raw_packet) {
-    if (raw_packet.empty() || raw_packet[0] != ESC_CODE) {
-        log_message("Invalid packet");
-        // log raw_packet
-        std::stringstream ss;
-        for (auto byte : raw_packet) {
-            ss << std::hex << static_cast<int>(byte) << " ";
-        }
-        log_message(ss.str());
+void Parser::parse_packet(const uint8_t* raw_packet, size_t length, const ReceiveContext& context) {
+    bump(metrics.messages);
+    if (length == 0 || raw_packet[0] != ESC_CODE) {
+        bump(metrics.invalid_packets);
+        log_message("Invalid packet", LogLevel::Warning);
+        log_raw_packet(raw_packet, length);
         return; // Ignore packets that don't start with ESC-CODE
     }
 
     Packet packet{};
+    packet.receive_timestamp_ns = context.receive_timestamp_ns;
+    packet.feed_id = context.feed_id;
+    packet.line_id = context.line_id;
     size_t offset = 1; // Start parsing after ESC-CODE
 
     // Parse the header
-    if (!parse_header(raw_packet, packet, offset)) {
-        log_message("Invalid header");
-        // log raw_packet
-        std::stringstream ss;
-        for (auto byte : raw_packet) {
-            ss << std::hex << static_cast<int>(byte) << " ";
+    if (!parse_header(raw_packet, length, packet, offset)) {
+        // A header that parsed far enough to read its format code was only filtered out
+        if (offset > 1) {
+            bump(metrics.filtered);
+            return;
         }
-        log_message(ss.str());
+        bump(metrics.invalid_headers);
+        log_message("Invalid header", LogLevel::Warning);
+        log_raw_packet(raw_packet, length);
         return; // Ignore invalid packets
     }
-    if (packet.format_code == 0x06 || packet.format_code == 0x17) {
-        if (!parse_body_06(raw_packet, packet, offset)) {
-            log_message("Invalid body for format code 0x06");
-            return;
+
+    // Single indirect call through the compile-time dispatch table
+    BodyDecoder decode_body = (*dispatch_table)[packet.format_code];
+    if (decode_body == nullptr) {
+        bump(metrics.filtered);
+        return; // Ignore unsupported format codes
+    }
+
+    // Every quote body starts with the stock code, so unsubscribed symbols stop here
+    if (!symbol_filter.empty() && packet.format_code != 0x14 && offset + 6 <= length &&
+        !symbol_filter.contains(reinterpret_cast<const char*>(raw_packet + offset))) {
+        // The arbiter and the state file still see the sequence number, or every filtered message
+        // would look like a gap. A corrupted one must not move a stream, so the frame is checked first.
+        if (arbitration_enabled || state_file) {
+            if (!validate_checksum(raw_packet, length, packet)) {
+                bump(metrics.checksum_failures);
+                return;
+            }
+            if (!validate_terminal_code(raw_packet, length, packet)) {
+                bump(metrics.terminal_failures);
+                return;
+            }
         }
-    } else if (packet.format_code == 0x14) {
-        if (!parse_body_14(raw_packet, packet, offset)) {
-            log_message("Invalid body for format code 0x14");
-            return;
+        bump(metrics.symbol_filtered);
+        if (arbitration_enabled) {
+            arbiter.accept(packet.feed_id, packet.format_code,
+                           static_cast<uint32_t>(bcd_to_binary(packet.transmission_number)));
         }
-    } else if (packet.format_code == 0x23) {
-        if (!parse_body_23(raw_packet, packet, offset)) {
-            log_message("Invalid body for format code 0x23");
-            return;
+        if (state_file) record_state_sequence(packet);
+        return;
+    }
+    if (!decode_body(raw_packet, length, packet, offset)) {
+        bump(metrics.invalid_bodies);
+        if (Logger::getInstance().should_log(LogLevel::Warning)) {
+            std::stringstream ss;
+            ss << "Invalid body for format code 0x" << std::hex << static_cast<int>(packet.format_code);
+            log_message(ss.str(), LogLevel::Warning);
         }
-    } else {
-        // log_message("Unsupported format code: " + std::to_string(packet.format_code));
-        return; // Ignore unsupported format codes
+        return;
     }
 
     // Validate the checksum
-    if (!validate_checksum(raw_packet, packet)) {
-        log_message("Invalid checksum");
-        // log raw_packet
-        std::stringstream ss;
-        for (auto byte : raw_packet) {
-            ss << std::hex << static_cast<int>(byte) << " ";
-        }
-        log_message(ss.str());
+    if (!validate_checksum(raw_packet, length, packet)) {
+        bump(metrics.checksum_failures);
+        log_message("Invalid checksum", LogLevel::Warning);
+        log_raw_packet(raw_packet, length);
         return; // Ignore invalid packets
     }
 
     // Validate the terminal code
-    if (!validate_terminal_code(raw_packet, packet)) {
-        log_message("Invalid terminal code");
+    if (!validate_terminal_code(raw_packet, length, packet)) {
+        bump(metrics.terminal_failures);
+        log_message("Invalid terminal code", LogLevel::Warning);
         return; // Ignore invalid packets
     }
 
+    if (decode_bcd && packet.format_code != 0x14 && !decode_packet_bcd(packet)) {
+        bump(metrics.invalid_bodies);
+        log_message("Price or quantity out of range", LogLevel::Warning);
+        log_raw_packet(raw_packet, length);
+        return;
+    }
+
+    // Drop copies already delivered from the other line
+    if (arbitration_enabled &&
+        !arbiter.accept(packet.feed_id, packet.format_code,
+                        static_cast<uint32_t>(bcd_to_binary(packet.transmission_number)))) {
+        bump(metrics.duplicates);
+        return;
+    }
+
+    if (state_file) record_state_sequence(packet);
+
+    if (snapshot_store && packet.format_code != 0x14) {
+        if (!snapshot_store->update(packet)) {
+            log_message("Snapshot store is full", LogLevel::Error);
+        }
+    }
+
+    if (warrant_index && packet.format_code == 0x14) {
+        if (!warrant_index->update(packet)) {
+            log_message("Warrant index is full", LogLevel::Error);
+        }
+    }
+
+    if (bar_engine && packet.format_code != 0x14) {
+        if (!bar_engine->update(packet)) {
+            log_message("Bar symbol table is full", LogLevel::Error);
+        }
+    }
+
+    if (tick_batch_rows != 0 && packet.format_code != 0x14) {
+        if (!tick_batch) tick_batch = std::make_shared<TickBatch>(tick_batch_rows);
+        tick_batch->append(packet);
+        if (tick_batch->full()) hand_over_tick_batch();
+    }
+
     // If all checks pass, invoke the callback
-    if (packet_callback) {
+    deliver(packet);
+}
+
+// Decode all BCD numbers of a message in one batch
+bool decode_packet_bcd(Packet& packet) {
+    uint64_t values[2 + 2 * PACKET_MAX_LEVELS];
+    size_t count = 0;
+    values[count++] = packet.match_time;
+    values[count++] = packet.cumulative_volume;
+    for (size_t i = 0; i < packet.level_count; ++i) {
+        values[count++] = raw_price(packet, i);
+        values[count++] = raw_quantity(packet, i);
+    }
+
+    bcd_to_binary_batch(values, count);
+
+    for (size_t i = 0; i < packet.level_count; ++i) {
+        if (values[2 + 2 * i] > UINT32_MAX || values[3 + 2 * i] > UINT32_MAX) return false;
+    }
+
+    // HHMMSSmmmuuu -> microseconds since midnight
+    uint64_t time = values[0];
+    packet.match_time = (time / 10000000000ULL) * 3600000000ULL +
+                        (time / 100000000ULL % 100) * 60000000ULL +
+                        time % 100000000ULL;
+    packet.cumulative_volume = values[1];
+    for (size_t i = 0; i < packet.level_count; ++i) {
+        packet.prices[i] = static_cast<uint32_t>(values[2 + 2 * i]);
+        packet.quantities[i] = static_cast<uint32_t>(values[3 + 2 * i]);
+        packet.price_high[i] = 0;
+        packet.quantity_high[i] = 0;
+    }
+    packet.bcd_decoded = 1;
+    return true;
+}
+
+// Invoke the callback inline, or queue the packet for the dispatch thread / poll()
+void Parser::deliver(const Packet& packet) {
+    if (shm_publisher) {
+        shm_publisher->publish(packet);
+    }
+
+    bump(metrics.delivered);
+
+    if (!packet_ring) {
+        if (batch_callback) {
+            // Collected and handed over at the end of the datagram
+            batch_buffer[batch_pending++] = packet;
+            if (batch_pending == batch_buffer.size()) flush_inline_batch();
+        } else {
+            invoke_callback(packet);
+        }
+        return;
+    }
+
+    switch (backpressure_policy) {
+    case BackpressurePolicy::DropOldest:
+        if (packet_ring->push_overwrite(packet)) {
+            ring_drops.fetch_add(1, std::memory_order_relaxed);
+        }
+        break;
+    case BackpressurePolicy::DropNewest:
+        if (!packet_ring->try_push(packet)) {
+            ring_drops.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        break;
+    case BackpressurePolicy::Block:
+        while (!packet_ring->try_push(packet)) {
+            if (!running) {
+                ring_drops.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            std::this_thread::yield();
+        }
+        break;
+    }
+
+    // Only the receive thread writes the high-water mark
+    uint64_t depth = packet_ring->size();
+    if (depth > ring_high_water.load(std::memory_order_relaxed)) {
+        ring_high_water.store(depth, std::memory_order_relaxed);
+    }
+}
+
+// Deliver queued packets until end_loop is called and the ring is empty
+void Parser::dispatch_loop() {
+    configure_thread(dispatch_cpu, "dispatch");
+
+    Packet packet;
+    std::vector<Packet> batch(batch_callback ? max_batch : 0);
+    while (true) {
+        if (batch_callback) {
+            // Hand over everything queued, up to max_batch, in one call
+            size_t count = 0;
+            while (count < batch.size() && packet_ring->try_pop(batch[count])) {
+                count++;
+            }
+            if (count > 0) {
+                invoke_batch_callback(batch.data(), count);
+                continue;
+            }
+        } else if (packet_ring->try_pop(packet)) {
+            invoke_callback(packet);
+            continue;
+        }
+
+        if (!dispatching) {
+            break;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Hand the packets collected by inline delivery to the batch callback
+void Parser::flush_inline_batch() {
+    if (batch_pending == 0) return;
+    size_t count = batch_pending;
+    batch_pending = 0;
+    invoke_batch_callback(batch_buffer.data(), count);
+}
+
+void Parser::invoke_callback(const Packet& packet) {
+    if (!packet_callback) return;
+    if (!latency_stats) {
         packet_callback(packet);
+        return;
+    }
+
+    uint64_t start = wall_clock_ns();
+    record_handoff_latency(&packet, 1, start);
+    packet_callback(packet);
+    metrics.callback_duration.record(wall_clock_ns() - start);
+}
+
+void Parser::invoke_batch_callback(const Packet* packets, size_t count) {
+    if (!latency_stats) {
+        batch_callback(packets, count);
+        return;
     }
+
+    uint64_t start = wall_clock_ns();
+    record_handoff_latency(packets, count, start);
+    batch_callback(packets, count);
+    metrics.callback_duration.record(wall_clock_ns() - start);
+}
+
+// Receive-to-callback latency of packets stamped on the live socket path
+void Parser::record_handoff_latency(const Packet* packets, size_t count, uint64_t now_ns) {
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t received = packets[i].receive_timestamp_ns;
+        if (received != 0 && received <= now_ns) {
+            metrics.receive_to_callback.record(now_ns - received);
+        }
+    }
+}
+
+ParserStats Parser::stats() const {
+    ParserStats result{};
+    result.datagrams_received = metrics.datagrams_received.load(std::memory_order_relaxed);
+    result.bytes_received = metrics.bytes_received.load(std::memory_order_relaxed);
+    result.messages = metrics.messages.load(std::memory_order_relaxed);
+    result.delivered = metrics.delivered.load(std::memory_order_relaxed);
+    result.filtered = metrics.filtered.load(std::memory_order_relaxed);
+    result.symbol_filtered = metrics.symbol_filtered.load(std::memory_order_relaxed);
+    result.invalid_packets = metrics.invalid_packets.load(std::memory_order_relaxed);
+    result.invalid_headers = metrics.invalid_headers.load(std::memory_order_relaxed);
+    result.invalid_bodies = metrics.invalid_bodies.load(std::memory_order_relaxed);
+    result.checksum_failures = metrics.checksum_failures.load(std::memory_order_relaxed);
+    result.terminal_failures = metrics.terminal_failures.load(std::memory_order_relaxed);
+    result.duplicates = metrics.duplicates.load(std::memory_order_relaxed);
+    result.ring_drops = ring_drops.load(std::memory_order_relaxed);
+    result.receive_to_callback = metrics.receive_to_callback.summary();
+    result.callback_duration = metrics.callback_duration.summary();
+    return result;
+}
+
+// Counters are written by the receive thread, so reset while the loop is stopped for exact zeros
+void Parser::reset_stats() {
+    metrics.reset();
+    ring_drops = 0;
+}
+
+void Parser::enable_latency_stats(bool enable) {
+    latency_stats = enable;
+}
+
+void Parser::set_stats_export(const std::string& file_path, int http_port, int interval_ms) {
+    stats_file = file_path;
+    stats_port = http_port;
+    stats_interval_ms = interval_ms;
 }
 
 // Parse the header
-bool Parser::parse_header(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset) {
-    if (offset + HEADER_LENGTH > raw_packet.size()) return false; // Ensure header length is valid
+bool Parser::parse_header(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset) {
+    if (offset + HEADER_LENGTH > length) return false; // Ensure header length is valid
 
     packet.message_length = (raw_packet[offset] << 8) | raw_packet[offset + 1];
     packet.business_type = raw_packet[offset + 2];
@@ -262,24 +1245,15 @@ bool Parser::parse_header(const std::vector<uint8_t>& raw_packet, Packet& packet
                                  raw_packet[offset + 8];
     offset += HEADER_LENGTH;
 
-    
-    if (allowed_format_codes.empty()) {
-        return false;
-    }
-    
-    if (!allowed_format_codes.empty() &&
-        std::find(allowed_format_codes.begin(), allowed_format_codes.end(), packet.format_code) == allowed_format_codes.end()) {
-        return false; // Not in the allowed list, so we skip this packet
-    }
-
-    return true; 
+    // Not in the allowed set, so we skip this packet
+    return allowed_formats.test(packet.format_code);
 }
 
 // Parse the body for format code 0x06, 0x17
-bool Parser::parse_body_06(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset) {
-    if (offset + 19 > raw_packet.size()) return false; // Minimum body size is 19 bytes
+bool Parser::parse_body_06(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset) {
+    if (offset + 19 > length) return false; // Minimum body size is 19 bytes
 
-    std::memcpy(packet.stock_code, &raw_packet[offset], 6);
+    std::memcpy(packet.stock_code, raw_packet + offset, 6);
     offset += 6;
 
     packet.match_time = 0;
@@ -297,23 +1271,24 @@ bool Parser::parse_body_06(const std::vector<uint8_t>& raw_packet, Packet& packe
     offset += 4;
 
     // Parse dynamic prices and quantities (if present)
-    while (offset + 9 <= raw_packet.size() - TERMINAL_CODE_SIZE - 1) {
-        // Warning: It is reasonable to discard the first byte since the stock price is likely 
-        // not to exceed 9,999.
+    while (offset + 9 <= length - TERMINAL_CODE_SIZE - 1 &&
+           packet.level_count < PACKET_MAX_LEVELS) {
+        // The first byte (prices from 10000 up) is kept apart so prices[] stays 32-bit
+        packet.price_high[packet.level_count] = raw_packet[offset];
         uint32_t price = (raw_packet[offset + 1] << 24) |
                          (raw_packet[offset + 2] << 16) |
                          (raw_packet[offset + 3] << 8) |
                          raw_packet[offset + 4];
-        packet.prices.push_back(price);
+        packet.prices[packet.level_count] = price;
         offset += 5;
 
-        if (offset + 4 > raw_packet.size()) break;
+        if (offset + 4 > length) break;
 
         uint32_t quantity = (raw_packet[offset] << 24) |
                             (raw_packet[offset + 1] << 16) |
                             (raw_packet[offset + 2] << 8) |
                             raw_packet[offset + 3];
-        packet.quantities.push_back(quantity);
+        packet.quantities[packet.level_count++] = quantity;
         offset += 4;
     }
 
@@ -321,41 +1296,41 @@ bool Parser::parse_body_06(const std::vector<uint8_t>& raw_packet, Packet& packe
 }
 
 // Parse the body for format code 0x14
-bool Parser::parse_body_14(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset) {
+bool Parser::parse_body_14(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset) {
     const size_t body_length = 56;
 
-    if (offset + body_length > raw_packet.size()) return false;
+    if (offset + body_length > length) return false;
 
-    std::memcpy(packet.stock_code, &raw_packet[offset], 6);
+    std::memcpy(packet.stock_code, raw_packet + offset, 6);
     offset += 6;
 
-    std::memcpy(packet.warrant_brief_name, &raw_packet[offset], 16);
+    std::memcpy(packet.warrant_brief_name, raw_packet + offset, 16);
     offset += 16;
-    std::memcpy(packet.separator, &raw_packet[offset], 2);
+    std::memcpy(packet.separator, raw_packet + offset, 2);
     offset += 2;
-    std::memcpy(packet.underlying_asset, &raw_packet[offset], 16);
+    std::memcpy(packet.underlying_asset, raw_packet + offset, 16);
     offset += 16;
-    std::memcpy(packet.expiration_date, &raw_packet[offset], 8);
+    std::memcpy(packet.expiration_date, raw_packet + offset, 8);
     offset += 8;
-    std::memcpy(packet.warrant_type_D, &raw_packet[offset], 2);
+    std::memcpy(packet.warrant_type_D, raw_packet + offset, 2);
     offset += 2;
-    std::memcpy(packet.warrant_type_E, &raw_packet[offset], 2);
+    std::memcpy(packet.warrant_type_E, raw_packet + offset, 2);
     offset += 2;
-    std::memcpy(packet.warrant_type_F, &raw_packet[offset], 2);
+    std::memcpy(packet.warrant_type_F, raw_packet + offset, 2);
     offset += 2;
-    std::memcpy(packet.reserved, &raw_packet[offset], 2);
+    std::memcpy(packet.reserved, raw_packet + offset, 2);
     offset += 2;
 
     return true;
 }
 
 // --- parse body for format 0x23 ---
-bool Parser::parse_body_23(const std::vector<uint8_t>& raw_packet, Packet& packet, size_t& offset) {
+bool Parser::parse_body_23(const uint8_t* raw_packet, size_t length, Packet& packet, size_t& offset) {
     // Minimum required: stock_code(6) + match_time(6) + display_item(1) + limit_up_limit_down(1) + status_note(1) + cumulative_volume(6)
     const size_t min_body_len = 6 + 6 + 1 + 1 + 1 + 6;
-    if (offset + min_body_len > raw_packet.size()) return false;
+    if (offset + min_body_len > length) return false;
 
-    std::memcpy(packet.stock_code, &raw_packet[offset], 6);
+    std::memcpy(packet.stock_code, raw_packet + offset, 6);
     offset += 6;
 
     packet.match_time = 0;
@@ -374,45 +1349,46 @@ bool Parser::parse_body_23(const std::vector<uint8_t>& raw_packet, Packet& packe
     }
 
     // Parse dynamic prices and quantities (if present) - same as format 0x23
-    while (offset + 11 <= raw_packet.size() - TERMINAL_CODE_SIZE - 1) {
+    while (offset + 11 <= length - TERMINAL_CODE_SIZE - 1 &&
+           packet.level_count < PACKET_MAX_LEVELS) {
         
         // Price (5 bytes PACK BCD)
         uint64_t price = 0;
         for (int i = 0; i < 5; ++i) {
             price = (price << 8) | raw_packet[offset++];
         }
-        packet.prices.push_back((uint32_t)price);
+        packet.prices[packet.level_count] = (uint32_t)price;
+        packet.price_high[packet.level_count] = static_cast<uint8_t>(price >> 32);
 
         // Check if remaining length is enough for quantity (6 bytes)
-        if (offset + 6 > raw_packet.size()) break;
+        if (offset + 6 > length) break;
 
         // Quantity (Format 23 is 6 bytes PACK BCD)
         uint64_t quantity = 0;
         for (int i = 0; i < 6; ++i) {
             quantity = (quantity << 8) | raw_packet[offset++];
         }
-        packet.quantities.push_back((uint32_t)quantity);
+        packet.quantities[packet.level_count] = (uint32_t)quantity;
+        packet.quantity_high[packet.level_count++] = static_cast<uint16_t>(quantity >> 32);
     }
 
     return true;
 }
 
 // Validate the checksum
-bool Parser::validate_checksum(const std::vector<uint8_t>& raw_packet, const Packet& packet) {
-    size_t checksum_position = calculate_checksum_position(raw_packet.size());
-    if (checksum_position >= raw_packet.size()) return false;
+bool Parser::validate_checksum(const uint8_t* raw_packet, size_t length, const Packet& packet) {
+    size_t checksum_position = calculate_checksum_position(length);
+    if (checksum_position >= length) return false;
 
-    uint8_t calculated_checksum = 0;
-    for (size_t i = 1; i < checksum_position; ++i) {
-        calculated_checksum ^= raw_packet[i];
-    }
+    // XOR of every byte after ESC-CODE up to the checksum
+    uint8_t calculated_checksum = checksum_position > 1 ? xor_checksum(raw_packet + 1, checksum_position - 1) : 0;
 
     return calculated_checksum == raw_packet[checksum_position];
 }
 
 // Validate the terminal code
-bool Parser::validate_terminal_code(const std::vector<uint8_t>& raw_packet, const Packet& packet) {
-    size_t terminal_position = raw_packet.size() - TERMINAL_CODE_SIZE;
+bool Parser::validate_terminal_code(const uint8_t* raw_packet, size_t length, const Packet& packet) {
+    size_t terminal_position = length - TERMINAL_CODE_SIZE;
     return raw_packet[terminal_position] == 0x0D &&
            raw_packet[terminal_position + 1] == 0x0A;
 }
@@ -422,9 +1398,16 @@ size_t Parser::calculate_checksum_position(size_t packet_length) const {
     return packet_length - TERMINAL_CODE_SIZE - 1; // -1 for checksum byte
 }
 
-// Add logging function
-void Parser::log_message(const std::string& message, bool error) {
-#ifdef DEBUG
-    Logger::getInstance().log(message, error);
-#endif
+// Add logging function; records are formatted and written by the logger's background thread
+void Parser::log_message(const std::string& message, LogLevel level) {
+    Logger::getInstance().log(level, message);
+}
+
+void Parser::log_message(const char* message, LogLevel level) {
+    Logger::getInstance().log(level, message);
+}
+
+// Hex dump of a rejected message; only the raw bytes are copied on the receive thread
+void Parser::log_raw_packet(const uint8_t* raw_packet, size_t length) {
+    Logger::getInstance().log_bytes(LogLevel::Debug, "Raw packet", raw_packet, length);
 }
@@ -1,7 +1,11 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/functional.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <algorithm>
 #include "parser.h"
+#include "batch_decoder.h"
+#include "shm_ring.h"
 
 namespace py = pybind11;
 
@@ -19,6 +23,70 @@ auto set_char_array(char (Packet::*pm)[N]) {
     };
 }
 
+// Expose the inline level arrays as lists of level_count entries
+template <typename T>
+auto get_levels(T (Packet::*pm)[PACKET_MAX_LEVELS]) {
+    return [pm](const Packet &p) {
+        return std::vector<T>(p.*pm, (p.*pm) + p.level_count);
+    };
+}
+
+template <typename T>
+auto set_levels(T (Packet::*pm)[PACKET_MAX_LEVELS]) {
+    return [pm](Packet &p, const std::vector<T> &values) {
+        if (values.size() > PACKET_MAX_LEVELS) {
+            throw std::runtime_error("Too many price/quantity levels!");
+        }
+        std::copy(values.begin(), values.end(), p.*pm);
+        p.level_count = static_cast<uint8_t>(values.size());
+    };
+}
+
+// Zero-copy view of one tick column (values or validity bitmap); keeps its batch alive
+struct TickColumnView {
+    std::shared_ptr<TickBatch> batch;
+    size_t column;
+    bool validity;
+};
+
+py::buffer_info tick_column_buffer(const TickColumnView &view) {
+    const TickBatch &batch = *view.batch;
+    if (view.validity) {
+        auto size = static_cast<py::ssize_t>((batch.size() + 7) / 8);
+        return py::buffer_info(const_cast<uint8_t *>(batch.validity(view.column)), 1,
+                               py::format_descriptor<uint8_t>::format(), 1, {size}, {1});
+    }
+
+    uint32_t width = TICK_SCHEMA[view.column].byte_width;
+    std::string format;
+    switch (width) {
+    case 1: format = py::format_descriptor<uint8_t>::format(); break;
+    case 4: format = py::format_descriptor<uint32_t>::format(); break;
+    case 8: format = py::format_descriptor<uint64_t>::format(); break;
+    default: format = std::to_string(width) + "s"; break; // Fixed-size binary, e.g. stock_code
+    }
+    return py::buffer_info(const_cast<uint8_t *>(batch.values(view.column)), width, format, 1,
+                           {static_cast<py::ssize_t>(batch.size())}, {static_cast<py::ssize_t>(width)});
+}
+
+// Parser's destructor stops the loop, joining threads that take the GIL to run callbacks;
+// the callbacks themselves hold Python objects, so they are released with the GIL held
+struct ParserDeleter {
+    void operator()(Parser *parser) const {
+        {
+            py::gil_scoped_release release;
+            parser->end_loop();
+        }
+        delete parser;
+    }
+};
+
+size_t tick_column_index(const std::string &name) {
+    int column = TickBatch::find_column(name);
+    if (column < 0) throw py::key_error("Unknown tick column: " + name);
+    return static_cast<size_t>(column);
+}
+
 PYBIND11_MODULE(twse_udp_resolver, m) {
     m.doc() = "TWSE UDP Resolver (Python interface)"; // optional module docstring
 
@@ -40,8 +108,11 @@ PYBIND11_MODULE(twse_udp_resolver, m) {
         .def_readwrite("limit_up_limit_down", &Packet::limit_up_limit_down)
         .def_readwrite("status_note", &Packet::status_note)
         .def_readwrite("cumulative_volume", &Packet::cumulative_volume)
-        .def_readwrite("prices", &Packet::prices)
-        .def_readwrite("quantities", &Packet::quantities)
+        .def_readwrite("level_count", &Packet::level_count)
+        .def_property("prices", get_levels(&Packet::prices), set_levels(&Packet::prices))
+        .def_property("quantities", get_levels(&Packet::quantities), set_levels(&Packet::quantities))
+        .def_property("price_high", get_levels(&Packet::price_high), set_levels(&Packet::price_high))
+        .def_property("quantity_high", get_levels(&Packet::quantity_high), set_levels(&Packet::quantity_high))
         .def_property("warrant_brief_name", [](const Packet &p) { return py::bytes(p.warrant_brief_name, 16); }, set_char_array<16>(&Packet::warrant_brief_name))
         .def_property("separator", [](const Packet &p) { return py::bytes(p.separator, 2); }, set_char_array<2>(&Packet::separator))
         .def_property("underlying_asset", [](const Packet &p) { return py::bytes(p.underlying_asset, 16); }, set_char_array<16>(&Packet::underlying_asset))
@@ -51,12 +122,392 @@ PYBIND11_MODULE(twse_udp_resolver, m) {
         .def_property("warrant_type_F", [](const Packet &p) { return py::bytes(p.warrant_type_F, 2); }, set_char_array<2>(&Packet::warrant_type_F))
         .def_property("reserved", [](const Packet &p) { return py::bytes(p.reserved, 2); }, set_char_array<2>(&Packet::reserved))
         .def_readwrite("checksum", &Packet::checksum)
-        .def_readwrite("terminal_code", &Packet::terminal_code);
+        .def_readwrite("terminal_code", &Packet::terminal_code)
+        .def_readwrite("receive_timestamp_ns", &Packet::receive_timestamp_ns)
+        .def_readwrite("feed_id", &Packet::feed_id)
+        .def_readwrite("line_id", &Packet::line_id)
+        .def_readwrite("bcd_decoded", &Packet::bcd_decoded);
+
+    // NumPy structured dtype with the exact Packet layout, for batched delivery
+    PYBIND11_NUMPY_DTYPE(Packet, esc_code, message_length, business_type, format_code, format_version,
+                         transmission_number, stock_code, match_time, display_item, limit_up_limit_down,
+                         status_note, cumulative_volume, level_count, prices, quantities, price_high,
+                         quantity_high, warrant_brief_name, separator, underlying_asset, expiration_date,
+                         warrant_type_D, warrant_type_E, warrant_type_F, reserved, checksum, terminal_code,
+                         receive_timestamp_ns, feed_id, line_id, bcd_decoded);
+    m.attr("packet_dtype") = py::dtype::of<Packet>();
+
+    PYBIND11_NUMPY_DTYPE(Bar, stock_code, format_code, feed_id, interval_ms, start_time, last_trade_time, open, high,
+                         low, close, vwap, trade_count, volume, turnover, cumulative_volume);
+    m.attr("bar_dtype") = py::dtype::of<Bar>();
+
+    py::enum_<LogLevel>(m, "LogLevel")
+        .value("Debug", LogLevel::Debug)
+        .value("Info", LogLevel::Info)
+        .value("Warning", LogLevel::Warning)
+        .value("Error", LogLevel::Error)
+        .value("Off", LogLevel::Off);
+
+    m.def("set_log_level", [](LogLevel level) { Logger::getInstance().set_level(level); },
+          "Minimum level written to the log file", py::arg("level"));
+    m.def("get_log_level", []() { return Logger::getInstance().get_level(); });
+    m.def("set_log_rate_limit", [](uint32_t per_second) { Logger::getInstance().set_rate_limit(per_second); },
+          "Maximum copies of one message per second per thread (0 = unlimited)", py::arg("per_second"));
+    m.def("flush_log", []() { Logger::getInstance().flush(); }, "Wait until queued log records are written",
+          py::call_guard<py::gil_scoped_release>());
+    m.def("get_log_drops", []() { return Logger::getInstance().get_dropped(); },
+          "Log records dropped because a thread's ring was full");
+
+    py::enum_<DispatchMode>(m, "DispatchMode")
+        .value("Inline", DispatchMode::Inline)
+        .value("Thread", DispatchMode::Thread)
+        .value("Poll", DispatchMode::Poll);
+
+    py::enum_<BackpressurePolicy>(m, "BackpressurePolicy")
+        .value("DropOldest", BackpressurePolicy::DropOldest)
+        .value("DropNewest", BackpressurePolicy::DropNewest)
+        .value("Block", BackpressurePolicy::Block);
+
+    py::enum_<IngestBackend>(m, "IngestBackend")
+        .value("Socket", IngestBackend::Socket)
+        .value("PacketMmap", IngestBackend::PacketMmap);
+
+    py::class_<GapEvent>(m, "GapEvent")
+        .def_readonly("feed_id", &GapEvent::feed_id)
+        .def_readonly("format_code", &GapEvent::format_code)
+        .def_readonly("first_missing", &GapEvent::first_missing)
+        .def_readonly("last_missing", &GapEvent::last_missing);
+
+    py::class_<ArbitrationStats>(m, "ArbitrationStats")
+        .def_readonly("delivered", &ArbitrationStats::delivered)
+        .def_readonly("duplicates", &ArbitrationStats::duplicates)
+        .def_readonly("gaps", &ArbitrationStats::gaps)
+        .def_readonly("missing", &ArbitrationStats::missing)
+        .def_readonly("out_of_order", &ArbitrationStats::out_of_order)
+        .def_readonly("resets", &ArbitrationStats::resets);
 
-    py::class_<Parser>(m, "Parser")
+    py::class_<LatencySummary>(m, "LatencySummary")
+        .def_readonly("count", &LatencySummary::count)
+        .def_readonly("min", &LatencySummary::min)
+        .def_readonly("max", &LatencySummary::max)
+        .def_readonly("mean", &LatencySummary::mean)
+        .def_readonly("p50", &LatencySummary::p50)
+        .def_readonly("p90", &LatencySummary::p90)
+        .def_readonly("p99", &LatencySummary::p99)
+        .def_readonly("p999", &LatencySummary::p999);
+
+    py::class_<ParserStats>(m, "ParserStats")
+        .def_readonly("datagrams_received", &ParserStats::datagrams_received)
+        .def_readonly("bytes_received", &ParserStats::bytes_received)
+        .def_readonly("messages", &ParserStats::messages)
+        .def_readonly("delivered", &ParserStats::delivered)
+        .def_readonly("filtered", &ParserStats::filtered)
+        .def_readonly("symbol_filtered", &ParserStats::symbol_filtered)
+        .def_readonly("invalid_packets", &ParserStats::invalid_packets)
+        .def_readonly("invalid_headers", &ParserStats::invalid_headers)
+        .def_readonly("invalid_bodies", &ParserStats::invalid_bodies)
+        .def_readonly("checksum_failures", &ParserStats::checksum_failures)
+        .def_readonly("terminal_failures", &ParserStats::terminal_failures)
+        .def_readonly("duplicates", &ParserStats::duplicates)
+        .def_readonly("ring_drops", &ParserStats::ring_drops)
+        .def_readonly("receive_to_callback", &ParserStats::receive_to_callback)
+        .def_readonly("callback_duration", &ParserStats::callback_duration);
+
+    m.def("format_prometheus", &format_prometheus, "Render parser stats in the Prometheus text format",
+          py::arg("stats"), py::arg("prefix") = "twse_parser");
+
+    py::class_<Bar>(m, "Bar")
+        .def_property_readonly("stock_code", [](const Bar &b) { return std::string(b.stock_code, 6); })
+        .def_readonly("format_code", &Bar::format_code)
+        .def_readonly("feed_id", &Bar::feed_id)
+        .def_readonly("interval_ms", &Bar::interval_ms)
+        .def_readonly("start_time", &Bar::start_time)
+        .def_readonly("last_trade_time", &Bar::last_trade_time)
+        .def_readonly("open", &Bar::open)
+        .def_readonly("high", &Bar::high)
+        .def_readonly("low", &Bar::low)
+        .def_readonly("close", &Bar::close)
+        .def_readonly("vwap", &Bar::vwap)
+        .def_readonly("trade_count", &Bar::trade_count)
+        .def_readonly("volume", &Bar::volume)
+        .def_readonly("turnover", &Bar::turnover)
+        .def_readonly("cumulative_volume", &Bar::cumulative_volume);
+
+    py::class_<BookSnapshot>(m, "BookSnapshot")
+        .def_property_readonly("stock_code", [](const BookSnapshot &s) { return std::string(s.stock_code, 6); })
+        .def_readonly("feed_id", &BookSnapshot::feed_id)
+        .def_readonly("format_code", &BookSnapshot::format_code)
+        .def_readonly("transmission_number", &BookSnapshot::transmission_number)
+        .def_readonly("match_time", &BookSnapshot::match_time)
+        .def_readonly("cumulative_volume", &BookSnapshot::cumulative_volume)
+        .def_readonly("limit_up_limit_down", &BookSnapshot::limit_up_limit_down)
+        .def_readonly("status_note", &BookSnapshot::status_note)
+        .def_readonly("bcd_decoded", &BookSnapshot::bcd_decoded)
+        .def_readonly("has_trade", &BookSnapshot::has_trade)
+        .def_readonly("trade_match_time", &BookSnapshot::trade_match_time)
+        .def_readonly("trade_price", &BookSnapshot::trade_price)
+        .def_readonly("trade_quantity", &BookSnapshot::trade_quantity)
+        .def_property_readonly("bid_prices", [](const BookSnapshot &s) { return std::vector<uint64_t>(s.bid_prices, s.bid_prices + s.bid_count); })
+        .def_property_readonly("bid_quantities", [](const BookSnapshot &s) { return std::vector<uint64_t>(s.bid_quantities, s.bid_quantities + s.bid_count); })
+        .def_property_readonly("ask_prices", [](const BookSnapshot &s) { return std::vector<uint64_t>(s.ask_prices, s.ask_prices + s.ask_count); })
+        .def_property_readonly("ask_quantities", [](const BookSnapshot &s) { return std::vector<uint64_t>(s.ask_quantities, s.ask_quantities + s.ask_count); })
+        .def_readonly("update_count", &BookSnapshot::update_count);
+
+    py::class_<WarrantInfo>(m, "WarrantInfo")
+        .def_property_readonly("warrant_code", [](const WarrantInfo &w) { return std::string(w.warrant_code, 6); })
+        .def_readonly("business_type", &WarrantInfo::business_type)
+        .def_property_readonly("brief_name", [](const WarrantInfo &w) { return py::bytes(w.brief_name, 16); })
+        .def_property_readonly("underlying_asset", [](const WarrantInfo &w) { return py::bytes(w.underlying_asset, 16); })
+        .def_property_readonly("expiration_date", [](const WarrantInfo &w) { return std::string(w.expiration_date, 8); })
+        .def_property_readonly("warrant_type_D", [](const WarrantInfo &w) { return py::bytes(w.warrant_type_D, 2); })
+        .def_property_readonly("warrant_type_E", [](const WarrantInfo &w) { return py::bytes(w.warrant_type_E, 2); })
+        .def_property_readonly("warrant_type_F", [](const WarrantInfo &w) { return py::bytes(w.warrant_type_F, 2); })
+        .def_readonly("id", &WarrantInfo::id)
+        .def_readonly("underlying_id", &WarrantInfo::underlying_id)
+        .def_readonly("update_count", &WarrantInfo::update_count);
+
+    py::class_<StateCheck>(m, "StateCheck")
+        .def_readonly("reattached", &StateCheck::reattached)
+        .def_readonly("checked", &StateCheck::checked)
+        .def_readonly("saved_sequence", &StateCheck::saved_sequence)
+        .def_readonly("first_sequence", &StateCheck::first_sequence)
+        .def_readonly("missed", &StateCheck::missed)
+        .def_readonly("session_restarted", &StateCheck::session_restarted);
+
+    py::class_<TickColumnView>(m, "TickColumn", py::buffer_protocol())
+        .def_buffer(&tick_column_buffer);
+
+    py::class_<TickBatch, std::shared_ptr<TickBatch>>(m, "TickBatch")
+        .def("__len__", &TickBatch::size)
+        .def_property_readonly("capacity", &TickBatch::capacity)
+        .def_static("column_names", []() {
+            std::vector<std::string> names;
+            for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) names.push_back(TICK_SCHEMA[c].name);
+            return names;
+        }, "Column names in schema order")
+        .def("column", [](std::shared_ptr<TickBatch> batch, const std::string &name) {
+            return TickColumnView{batch, tick_column_index(name), false};
+        }, "Values buffer of a column (use numpy.asarray for a zero-copy array)", py::arg("name"))
+        .def("validity", [](std::shared_ptr<TickBatch> batch, const std::string &name) -> py::object {
+            size_t column = tick_column_index(name);
+            if (!TICK_SCHEMA[column].nullable) return py::none();
+            return py::cast(TickColumnView{batch, column, true});
+        }, "Arrow validity bitmap of a nullable column (LSB first, 1 = present), or None", py::arg("name"))
+        .def("null_count", [](const TickBatch &batch, const std::string &name) {
+            return batch.null_count(tick_column_index(name));
+        }, py::arg("name"))
+        .def("columns", [](std::shared_ptr<TickBatch> batch) {
+            py::dict columns;
+            for (size_t c = 0; c < TICK_COLUMN_COUNT; ++c) {
+                columns[TICK_SCHEMA[c].name] = py::cast(TickColumnView{batch, c, false});
+            }
+            return columns;
+        }, "All value buffers keyed by column name");
+
+    py::class_<ShmSubscriber>(m, "ShmSubscriber")
+        .def(py::init<>())
+        .def("open", &ShmSubscriber::open, "Attach to a publisher's shared-memory ring", py::arg("name"))
+        .def("close", &ShmSubscriber::close)
+        .def("next", [](ShmSubscriber &subscriber) -> py::object {
+            Packet packet;
+            if (!subscriber.next(packet)) return py::none();
+            return py::cast(packet);
+        }, "Next packet, or None when caught up")
+        .def("poll_batch", [](ShmSubscriber &subscriber, size_t max_packets, int timeout_ms) {
+            py::array_t<Packet> packets(static_cast<py::ssize_t>(max_packets));
+            size_t count;
+            {
+                py::gil_scoped_release release;
+                count = subscriber.poll(packets.mutable_data(), max_packets, timeout_ms);
+            }
+            packets.resize({static_cast<py::ssize_t>(count)});
+            return packets;
+        }, "Up to max_packets packets as a NumPy structured array; waits up to timeout_ms for the first",
+             py::arg("max_packets"), py::arg("timeout_ms") = 0)
+        .def("poll_into", [](ShmSubscriber &subscriber, py::array_t<Packet, py::array::c_style> out, int timeout_ms) {
+            if (out.ndim() != 1) throw std::runtime_error("poll_into expects a 1-D array of packet_dtype");
+            Packet *data = out.mutable_data();
+            size_t capacity = static_cast<size_t>(out.shape(0));
+            py::gil_scoped_release release;
+            return subscriber.poll(data, capacity, timeout_ms);
+        }, "Fill a preallocated packet_dtype array; returns the number of packets written",
+             py::arg("out"), py::arg("timeout_ms") = 0)
+        .def("get_lost", &ShmSubscriber::get_lost, "Packets overwritten before they were read")
+        .def("get_backlog", &ShmSubscriber::get_backlog, "Packets published but not yet read")
+        .def("publisher_closed", &ShmSubscriber::publisher_closed);
+
+    py::class_<Parser, std::unique_ptr<Parser, ParserDeleter>>(m, "Parser")
         .def(py::init<>())
-        .def("start_loop", &Parser::start_loop, "Start the UDP stream parsing loop")
-        .def("end_loop", &Parser::end_loop, "Stop the parsing loop")
+        .def("start_loop", py::overload_cast<int, const PacketCallback&>(&Parser::start_loop), "Start the UDP stream parsing loop")
+        .def("start_loop", py::overload_cast<const PacketCallback&>(&Parser::start_loop), "Start the parsing loop over added subscriptions")
+        .def("add_subscription", &Parser::add_subscription, "Add a (port, multicast group, interface) source tagged with feed_id",
+             py::arg("feed_id"), py::arg("port"), py::arg("group") = "", py::arg("iface") = "")
+        .def("end_loop", &Parser::end_loop, "Stop the parsing loop", py::call_guard<py::gil_scoped_release>())
         .def("set_multicast", &Parser::set_multicast, "Sets the parameter of multicast")
-        .def("set_allowed_format_codes", &Parser::set_allowed_format_codes, "Set the allowed format codes");
+        .def("set_allowed_format_codes", &Parser::set_allowed_format_codes, "Set the allowed format codes")
+        .def("set_symbol_filter", &Parser::set_symbol_filter,
+             "Only decode quotes of these stock codes; an empty list turns the filter off", py::arg("stock_codes"))
+        .def("set_batch_receive", &Parser::set_batch_receive, "Receive up to N datagrams per recvmmsg call")
+        .def("set_kernel_timestamps", &Parser::set_kernel_timestamps, "Stamp packets with the kernel receive time")
+        .def("set_cpu_affinity", &Parser::set_cpu_affinity, "Pin the receive and dispatch threads to CPU cores",
+             py::arg("receive_cpu"), py::arg("dispatch_cpu") = -1)
+        .def("set_realtime_priority", &Parser::set_realtime_priority,
+             "Run the receive and dispatch threads under SCHED_FIFO (0 disables)")
+        .def("set_busy_poll", &Parser::set_busy_poll, "Spin instead of sleeping in epoll_wait; optional SO_BUSY_POLL",
+             py::arg("enable"), py::arg("busy_poll_us") = 0)
+        .def("set_receive_buffer_size", &Parser::set_receive_buffer_size, "Socket receive buffer size in bytes")
+        .def("set_ingest_backend", &Parser::set_ingest_backend,
+             "Receive through UDP sockets or an AF_PACKET TPACKET_V3 ring on an interface",
+             py::arg("backend"), py::arg("interface") = "", py::arg("ring_size") = 32 << 20,
+             py::arg("block_timeout_ms") = 1)
+        .def("set_dispatch_mode", &Parser::set_dispatch_mode, "Decouple the callback from the receive thread",
+             py::arg("mode"), py::arg("ring_capacity") = 65536, py::arg("policy") = BackpressurePolicy::DropOldest)
+        .def("poll", &Parser::poll, "Deliver queued packets on the calling thread", py::call_guard<py::gil_scoped_release>())
+        .def("set_batch_callback", [](Parser &parser, size_t max_batch, const std::function<void(py::array_t<Packet>)> &callback) {
+            // One GIL acquisition and one NumPy array per batch instead of per packet
+            parser.set_batch_callback(max_batch, [callback](const Packet *packets, size_t count) {
+                py::gil_scoped_acquire acquire;
+                callback(py::array_t<Packet>(static_cast<py::ssize_t>(count), packets));
+            });
+        }, "Receive packets as NumPy structured arrays (dtype packet_dtype) of up to max_batch rows",
+             py::arg("max_batch"), py::arg("callback"))
+        .def("poll_batch", [](Parser &parser, size_t max_packets, int timeout_ms) {
+            py::array_t<Packet> packets(static_cast<py::ssize_t>(max_packets));
+            size_t count;
+            {
+                py::gil_scoped_release release;
+                count = parser.poll_batch(packets.mutable_data(), max_packets, timeout_ms);
+            }
+            packets.resize({static_cast<py::ssize_t>(count)});
+            return packets;
+        }, "Up to max_packets queued packets as a NumPy structured array; waits up to timeout_ms for the first",
+             py::arg("max_packets"), py::arg("timeout_ms") = 0)
+        .def("poll_into", [](Parser &parser, py::array_t<Packet, py::array::c_style> out, int timeout_ms) {
+            if (out.ndim() != 1) throw std::runtime_error("poll_into expects a 1-D array of packet_dtype");
+            Packet *data = out.mutable_data();
+            size_t capacity = static_cast<size_t>(out.shape(0));
+            py::gil_scoped_release release;
+            return parser.poll_batch(data, capacity, timeout_ms);
+        }, "Fill a preallocated packet_dtype array; returns the number of packets written",
+             py::arg("out"), py::arg("timeout_ms") = 0)
+        .def("get_ring_high_water", &Parser::get_ring_high_water, "Maximum observed dispatch ring depth")
+        .def("get_ring_drops", &Parser::get_ring_drops, "Packets dropped because the dispatch ring was full")
+        .def("set_capture_file", &Parser::set_capture_file, "Record raw datagrams to a capture file")
+        .def("get_capture_drops", &Parser::get_capture_drops, "Datagrams dropped by the capture writer")
+        .def("replay", &Parser::replay, "Parse a capture file through the regular parse path",
+             py::arg("path"), py::arg("callback"), py::arg("paced") = false, py::call_guard<py::gil_scoped_release>())
+        .def("set_decode_bcd", &Parser::set_decode_bcd, "Decode BCD times, volumes, prices and quantities to integers")
+        .def("set_arbitration", &Parser::set_arbitration, "Deduplicate A/B lines on transmission_number")
+        .def("set_gap_callback", &Parser::set_gap_callback, "Callback invoked when skipped transmission numbers can no longer arrive from the other line")
+        .def("get_arbitration_stats", &Parser::get_arbitration_stats, "Arbitration counters for one feed")
+        .def("set_tick_batches", &Parser::set_tick_batches, "Accumulate ticks into columnar batches handed to a callback",
+             py::arg("rows"), py::arg("callback"))
+        .def("set_tick_file", &Parser::set_tick_file, "Write columnar tick batches to a file",
+             py::arg("path"), py::arg("rows") = 65536)
+        .def("flush_tick_batch", &Parser::flush_tick_batch, "Hand over the partially filled tick batch; only while stopped (end_loop and replay already do it)")
+        .def("set_shm_publisher", &Parser::set_shm_publisher, "Publish delivered packets to a shared-memory ring",
+             py::arg("name"), py::arg("capacity") = 65536)
+        .def("stats", &Parser::stats, "Counters and latency percentiles")
+        .def("reset_stats", &Parser::reset_stats, "Zero all counters and histograms")
+        .def("enable_latency_stats", &Parser::enable_latency_stats,
+             "Record receive-to-callback latency and callback duration")
+        .def("set_stats_export", &Parser::set_stats_export, "Export stats to a Prometheus textfile and/or HTTP port",
+             py::arg("file_path"), py::arg("http_port") = 0, py::arg("interval_ms") = 1000)
+        .def("enable_snapshot_store", &Parser::enable_snapshot_store, "Keep the latest book per symbol",
+             py::arg("capacity") = 32768)
+        .def("get_snapshot", [](const Parser &parser, const std::string &stock_code, uint8_t format_code) -> py::object {
+            BookSnapshot snapshot;
+            if (!parser.get_snapshot(stock_code, snapshot, format_code)) return py::none();
+            return py::cast(snapshot);
+        }, "Latest book for a stock code, or None", py::arg("stock_code"), py::arg("format_code") = 0x06)
+        .def("enable_warrant_index", &Parser::enable_warrant_index,
+             "Index Format 14 warrant reference data by code and by underlying", py::arg("capacity") = 65536)
+        .def("get_warrant", [](const Parser &parser, const std::string &warrant_code) -> py::object {
+            WarrantInfo warrant;
+            if (!parser.get_warrant(warrant_code, warrant)) return py::none();
+            return py::cast(warrant);
+        }, "Reference data of a warrant, or None", py::arg("warrant_code"))
+        .def("get_warrants_on", &Parser::get_warrants_on,
+             "Warrants on an underlying stock code (str) or underlying_asset field (bytes)", py::arg("underlying"))
+        .def("set_state_file", &Parser::set_state_file,
+             "Keep books, warrants and stream positions in a memory-mapped file; True if reattached",
+             py::arg("path"), py::arg("snapshot_capacity") = 32768, py::arg("warrant_capacity") = 65536)
+        .def("get_state_check", &Parser::get_state_check,
+             "Compare the saved transmission_number of a stream with the live feed",
+             py::arg("feed_id"), py::arg("format_code"))
+        .def("enable_bars", &Parser::enable_bars, "Aggregate trades into OHLCV / VWAP bars per interval",
+             py::arg("intervals_ms"), py::arg("capacity") = 32768)
+        .def("set_bar_callback", &Parser::set_bar_callback, "Callback invoked with every completed Bar")
+        .def("poll_bars", [](Parser &parser, size_t max_bars) {
+            py::array_t<Bar> bars(static_cast<py::ssize_t>(max_bars));
+            size_t count = parser.poll_bars(bars.mutable_data(), max_bars);
+            bars.resize({static_cast<py::ssize_t>(count)});
+            return bars;
+        }, "Up to max_bars completed bars as a NumPy structured array (dtype bar_dtype)",
+             py::arg("max_bars") = 4096)
+        .def("flush_bars", &Parser::flush_bars, "Close the bars still open; only while stopped (end_loop and replay already do it)")
+        .def("get_bar_drops", &Parser::get_bar_drops, "Bars dropped because the bar queue was full");
+
+    m.def("decode_file", [](const std::string &path, size_t threads, const std::vector<uint8_t> &format_codes,
+                            const std::vector<std::pair<uint16_t, uint8_t>> &port_feeds, bool decode_bcd, bool deduplicate,
+                            py::object callback) -> py::object {
+        BatchDecodeOptions options;
+        options.threads = threads;
+        options.format_codes = format_codes;
+        options.port_feeds = port_feeds;
+        options.decode_bcd = decode_bcd;
+        options.deduplicate = deduplicate;
+
+        bool ok;
+        if (!callback.is_none()) {
+            // Stream the file as packet_dtype arrays instead of holding all of it
+            {
+                py::gil_scoped_release release;
+                ok = decode_capture_file(path, options, [&callback](const Packet *packets, size_t count) {
+                    py::gil_scoped_acquire acquire;
+                    callback(py::array_t<Packet>(static_cast<py::ssize_t>(count), packets));
+                });
+            }
+            if (!ok) throw std::runtime_error("Failed to open " + path + " as a pcap or capture file");
+            return py::none();
+        }
+
+        std::vector<Packet> packets;
+        {
+            py::gil_scoped_release release;
+            ok = decode_capture_file(path, options, packets);
+        }
+        if (!ok) throw std::runtime_error("Failed to open " + path + " as a pcap or capture file");
+        return py::cast(std::move(packets));
+    }, "Decode a pcap or capture file in parallel; within each stream packets follow transmission_number. "
+       "With a callback, it receives packet_dtype arrays as the file is decoded and nothing is returned",
+       py::arg("path"), py::arg("threads") = 0, py::arg("format_codes") = std::vector<uint8_t>(),
+       py::arg("port_feeds") = std::vector<std::pair<uint16_t, uint8_t>>(), py::arg("decode_bcd") = false,
+       py::arg("deduplicate") = true, py::arg("callback") = py::none());
+
+    m.def("decode_file_ticks", [](const std::string &path, size_t threads, const std::vector<uint8_t> &format_codes,
+                                  const std::vector<std::pair<uint16_t, uint8_t>> &port_feeds, bool deduplicate) {
+        BatchDecodeOptions options;
+        options.threads = threads;
+        options.format_codes = format_codes;
+        options.port_feeds = port_feeds;
+        options.deduplicate = deduplicate;
+
+        std::shared_ptr<TickBatch> batch;
+        {
+            py::gil_scoped_release release;
+            std::vector<Packet> packets;
+            if (decode_capture_file(path, options, packets)) batch = TickBatch::from_packets(packets);
+        }
+        if (!batch) throw std::runtime_error("Failed to open " + path + " as a pcap or capture file");
+        return batch;
+    }, "Decode a pcap or capture file straight into one columnar TickBatch",
+       py::arg("path"), py::arg("threads") = 0, py::arg("format_codes") = std::vector<uint8_t>(),
+       py::arg("port_feeds") = std::vector<std::pair<uint16_t, uint8_t>>(), py::arg("deduplicate") = true);
+
+    m.def("read_tick_file", [](const std::string &path) {
+        std::vector<std::shared_ptr<TickBatch>> batches;
+        if (!read_tick_file(path, batches)) throw std::runtime_error("Failed to read tick file: " + path);
+        return batches;
+    }, "Read every batch of a columnar tick file", py::arg("path"));
 }
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "shm_ring.h"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+size_t ring_bytes(uint64_t capacity) {
+    return sizeof(ShmRingHeader) + capacity * sizeof(ShmRingSlot);
+}
+
+} // namespace
+
+ShmPublisher::~ShmPublisher() {
+    close();
+}
+
+bool ShmPublisher::open(const std::string& name, size_t capacity) {
+    close();
+
+    uint64_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+
+    // Replace any segment left behind by a previous run; attached readers keep the old one
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+
+    size_t size = ring_bytes(rounded);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // ftruncate zero-fills the segment, so every slot starts with sequence 0 (never written)
+    header = new (mapped) ShmRingHeader;
+    header->version = SHM_RING_VERSION;
+    header->slot_size = sizeof(ShmRingSlot);
+    header->capacity = rounded;
+    header->closed.store(0, std::memory_order_relaxed);
+    header->write_sequence.store(0, std::memory_order_relaxed);
+    slots = reinterpret_cast<ShmRingSlot*>(static_cast<uint8_t*>(mapped) + sizeof(ShmRingHeader));
+
+    // Readers check the magic first, so it is written last
+    header->magic.store(SHM_RING_MAGIC, std::memory_order_release);
+
+    this->name = name;
+    mapping_size = size;
+    mask = rounded - 1;
+    next_sequence = 0;
+    return true;
+}
+
+void ShmPublisher::close() {
+    if (header == nullptr) return;
+
+    header->closed.store(1, std::memory_order_release);
+    munmap(header, mapping_size);
+    shm_unlink(name.c_str());
+    header = nullptr;
+    slots = nullptr;
+    mapping_size = 0;
+}
+
+void ShmPublisher::publish(const Packet& packet) {
+    uint64_t sequence = next_sequence++;
+    ShmRingSlot& slot = slots[sequence & mask];
+
+    slot.sequence.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.packet, &packet, sizeof(Packet));
+    slot.sequence.store(2 * sequence + 2, std::memory_order_release);
+
+    header->write_sequence.store(sequence + 1, std::memory_order_release);
+}
+
+ShmSubscriber::~ShmSubscriber() {
+    close();
+}
+
+bool ShmSubscriber::open(const std::string& name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    const ShmRingHeader* ring = static_cast<const ShmRingHeader*>(mapped);
+    if (ring->magic.load(std::memory_order_acquire) != SHM_RING_MAGIC || ring->version != SHM_RING_VERSION ||
+        ring->slot_size != sizeof(ShmRingSlot) || ring_bytes(ring->capacity) > static_cast<size_t>(st.st_size)) {
+        munmap(mapped, st.st_size);
+        return false;
+    }
+
+    header = ring;
+    slots = reinterpret_cast<const ShmRingSlot*>(static_cast<const uint8_t*>(mapped) + sizeof(ShmRingHeader));
+    mapping_size = st.st_size;
+    mask = ring->capacity - 1;
+    cursor = ring->write_sequence.load(std::memory_order_acquire);
+    lost = 0;
+    return true;
+}
+
+void ShmSubscriber::close() {
+    if (header == nullptr) return;
+    munmap(const_cast<ShmRingHeader*>(header), mapping_size);
+    header = nullptr;
+    slots = nullptr;
+    mapping_size = 0;
+}
+
+bool ShmSubscriber::next(Packet& out) {
+    if (header == nullptr) return false;
+
+    while (true) {
+        uint64_t written = header->write_sequence.load(std::memory_order_acquire);
+        if (cursor >= written) return false;
+
+        // Lapped by the writer: skip to the oldest packet that can still be intact
+        if (written - cursor > header->capacity) {
+            lost += written - header->capacity - cursor;
+            cursor = written - header->capacity;
+        }
+
+        const ShmRingSlot& slot = slots[cursor & mask];
+        uint64_t expected = 2 * cursor + 2;
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == expected) {
+            std::memcpy(&out, &slot.packet, sizeof(Packet));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+                cursor++;
+                return true;
+            }
+        }
+
+        // The slot was reused while we looked at it; count it and move on
+        lost++;
+        cursor++;
+    }
+}
+
+size_t ShmSubscriber::poll(Packet* out, size_t max_packets, int timeout_ms) {
+    if (header == nullptr || max_packets == 0) return 0;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    size_t count = 0;
+    for (unsigned spins = 0; ; ++spins) {
+        while (count < max_packets && next(out[count])) {
+            count++;
+        }
+        if (count > 0 || timeout_ms == 0 || publisher_closed()) break;
+        if (timeout_ms > 0 && std::chrono::steady_clock::now() >= deadline) break;
+
+        if (spins < 1000) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    return count;
+}
+
+uint64_t ShmSubscriber::get_backlog() const {
+    if (header == nullptr) return 0;
+    uint64_t written = header->write_sequence.load(std::memory_order_acquire);
+    return written > cursor ? written - cursor : 0;
+}
+
+bool ShmSubscriber::publisher_closed() const {
+    return header == nullptr || header->closed.load(std::memory_order_acquire) != 0;
+}
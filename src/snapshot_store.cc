@@ -0,0 +1,153 @@
+#include "snapshot_store.h"
+#include "parser.h"
+#include "symbol.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+size_t rounded_capacity(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    return rounded;
+}
+
+} // namespace
+
+SnapshotStore::SnapshotStore(size_t capacity) {
+    size_t rounded = rounded_capacity(capacity);
+    owned.reset(new Slot[rounded]);
+    slots = owned.get();
+    mask = rounded - 1;
+
+    for (size_t i = 0; i < rounded; ++i) {
+        slots[i].key.store(0, std::memory_order_relaxed);
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+        std::memset(&slots[i].snapshot, 0, sizeof(BookSnapshot));
+    }
+}
+
+SnapshotStore::SnapshotStore(size_t capacity, void* memory, bool attach) {
+    size_t rounded = rounded_capacity(capacity);
+    slots = static_cast<Slot*>(memory);
+    mask = rounded - 1;
+
+    for (size_t i = 0; i < rounded; ++i) {
+        if (!attach) {
+            new (&slots[i]) Slot;
+            slots[i].key.store(0, std::memory_order_relaxed);
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+            std::memset(&slots[i].snapshot, 0, sizeof(BookSnapshot));
+            continue;
+        }
+        if (slots[i].key.load(std::memory_order_relaxed) != 0) count.fetch_add(1, std::memory_order_relaxed);
+        // A writer that died mid-update left the sequence odd, which would block readers forever
+        uint32_t sequence = slots[i].sequence.load(std::memory_order_relaxed);
+        if (sequence & 1) slots[i].sequence.store(sequence + 1, std::memory_order_relaxed);
+    }
+}
+
+size_t SnapshotStore::memory_size(size_t capacity) {
+    return rounded_capacity(capacity) * sizeof(Slot);
+}
+
+uint64_t SnapshotStore::book_key(uint64_t stock_key, uint8_t format_code) {
+    return format_code == 0x23 ? stock_key | (uint64_t(1) << 48) : stock_key;
+}
+
+bool SnapshotStore::update(const Packet& packet) {
+    uint64_t key = book_key(pack_stock_code(packet.stock_code), packet.format_code);
+
+    // Probe for the symbol, claiming the first empty slot if it is new
+    Slot* slot = nullptr;
+    for (size_t i = 0, index = hash_stock_key(key) & mask; i <= mask; ++i, index = (index + 1) & mask) {
+        uint64_t current = slots[index].key.load(std::memory_order_relaxed);
+        if (current == key || current == 0) {
+            slot = &slots[index];
+            break;
+        }
+    }
+    if (slot == nullptr) return false;
+
+    uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    BookSnapshot& snapshot = slot->snapshot;
+    std::memcpy(snapshot.stock_code, packet.stock_code, 6);
+    snapshot.feed_id = packet.feed_id;
+    snapshot.format_code = packet.format_code;
+    snapshot.transmission_number = packet.transmission_number;
+    snapshot.match_time = packet.match_time;
+    snapshot.cumulative_volume = packet.cumulative_volume;
+    snapshot.limit_up_limit_down = packet.limit_up_limit_down;
+    snapshot.status_note = packet.status_note;
+    snapshot.bcd_decoded = packet.bcd_decoded;
+
+    // display_item: bit 7 trade, bits 6-4 bid levels, bits 3-1 ask levels
+    bool has_trade = (packet.display_item & 0b10000000) != 0;
+    uint8_t bid_count = (packet.display_item & 0b01110000) >> 4;
+    uint8_t ask_count = (packet.display_item & 0b00001110) >> 1;
+    if (bid_count > 5) bid_count = 5;
+    if (ask_count > 5) ask_count = 5;
+
+    size_t level = 0;
+    if (has_trade && level < packet.level_count) {
+        snapshot.has_trade = true;
+        snapshot.trade_match_time = packet.match_time;
+        snapshot.trade_price = raw_price(packet, level);
+        snapshot.trade_quantity = raw_quantity(packet, level);
+        level++;
+    }
+
+    snapshot.bid_count = 0;
+    for (uint8_t i = 0; i < bid_count && level < packet.level_count; ++i, ++level) {
+        snapshot.bid_prices[i] = raw_price(packet, level);
+        snapshot.bid_quantities[i] = raw_quantity(packet, level);
+        snapshot.bid_count++;
+    }
+
+    snapshot.ask_count = 0;
+    for (uint8_t i = 0; i < ask_count && level < packet.level_count; ++i, ++level) {
+        snapshot.ask_prices[i] = raw_price(packet, level);
+        snapshot.ask_quantities[i] = raw_quantity(packet, level);
+        snapshot.ask_count++;
+    }
+
+    snapshot.update_count++;
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+
+    // Publish the key last so readers never see a half-initialised new symbol
+    if (slot->key.load(std::memory_order_relaxed) == 0) {
+        slot->key.store(key, std::memory_order_release);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool SnapshotStore::lookup(const char* stock_code, BookSnapshot& out, uint8_t format_code) const {
+    return lookup_key(book_key(pack_stock_code(stock_code), format_code), out);
+}
+
+bool SnapshotStore::lookup(const std::string& stock_code, BookSnapshot& out, uint8_t format_code) const {
+    return lookup_key(book_key(pack_stock_code(stock_code), format_code), out);
+}
+
+bool SnapshotStore::lookup_key(uint64_t key, BookSnapshot& out) const {
+    for (size_t i = 0, index = hash_stock_key(key) & mask; i <= mask; ++i, index = (index + 1) & mask) {
+        const Slot& slot = slots[index];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0) return false;
+        if (current != key) continue;
+
+        while (true) {
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) continue; // Writer in progress
+            std::memcpy(&out, &slot.snapshot, sizeof(BookSnapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) return true;
+        }
+    }
+    return false;
+}
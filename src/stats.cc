@@ -0,0 +1,225 @@
+#include "stats.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    size_t group = index / SUB_BUCKETS;
+    size_t sub = index % SUB_BUCKETS;
+    unsigned shift = static_cast<unsigned>(group - 1);
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    minimum.store(UINT64_MAX, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary summary{};
+
+    uint64_t counts[BUCKET_COUNT];
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    if (summary.count == 0) return summary;
+
+    summary.min = minimum.load(std::memory_order_relaxed);
+    summary.max = maximum.load(std::memory_order_relaxed);
+    summary.mean = total.load(std::memory_order_relaxed) / summary.count;
+
+    // Each percentile is reported as the upper bound of the bucket it lands in
+    const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t* outputs[4] = {&summary.p50, &summary.p90, &summary.p99, &summary.p999};
+    uint64_t seen = 0;
+    size_t q = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && q < 4; ++i) {
+        seen += counts[i];
+        while (q < 4 && seen >= static_cast<uint64_t>(quantiles[q] * summary.count + 0.5) && seen > 0) {
+            uint64_t bound = bucket_upper_bound(i);
+            *outputs[q++] = bound < summary.max ? bound : summary.max;
+        }
+    }
+    while (q < 4) *outputs[q++] = summary.max;
+    return summary;
+}
+
+void ParserMetrics::reset() {
+    for (auto* counter : {&datagrams_received, &bytes_received, &messages, &delivered, &filtered, &symbol_filtered,
+                          &invalid_packets, &invalid_headers, &invalid_bodies, &checksum_failures,
+                          &terminal_failures, &duplicates}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    receive_to_callback.reset();
+    callback_duration.reset();
+}
+
+namespace {
+
+void write_counter(std::ostringstream& out, const std::string& prefix, const char* name, const char* help,
+                   uint64_t value) {
+    out << "# HELP " << prefix << '_' << name << ' ' << help << '\n'
+        << "# TYPE " << prefix << '_' << name << " counter\n"
+        << prefix << '_' << name << ' ' << value << '\n';
+}
+
+void write_summary(std::ostringstream& out, const std::string& prefix, const char* name, const char* help,
+                   const LatencySummary& summary) {
+    std::string metric = prefix + '_' + name + "_seconds";
+    out << "# HELP " << metric << ' ' << help << '\n'
+        << "# TYPE " << metric << " summary\n";
+
+    const char* labels[4] = {"0.5", "0.9", "0.99", "0.999"};
+    const uint64_t values[4] = {summary.p50, summary.p90, summary.p99, summary.p999};
+    char seconds[32];
+    for (int i = 0; i < 4; ++i) {
+        snprintf(seconds, sizeof(seconds), "%.9f", values[i] / 1e9);
+        out << metric << "{quantile=\"" << labels[i] << "\"} " << seconds << '\n';
+    }
+    snprintf(seconds, sizeof(seconds), "%.9f", summary.mean * summary.count / 1e9);
+    out << metric << "_sum " << seconds << '\n'
+        << metric << "_count " << summary.count << '\n';
+}
+
+} // namespace
+
+std::string format_prometheus(const ParserStats& stats, const std::string& prefix) {
+    std::ostringstream out;
+    write_counter(out, prefix, "datagrams_received_total", "UDP datagrams received", stats.datagrams_received);
+    write_counter(out, prefix, "bytes_received_total", "UDP payload bytes received", stats.bytes_received);
+    write_counter(out, prefix, "messages_total", "Framed messages parsed", stats.messages);
+    write_counter(out, prefix, "delivered_total", "Packets delivered", stats.delivered);
+    write_counter(out, prefix, "filtered_total", "Messages skipped by the format filter", stats.filtered);
+    write_counter(out, prefix, "symbol_filtered_total", "Messages skipped by the symbol filter",
+                  stats.symbol_filtered);
+    write_counter(out, prefix, "invalid_packets_total", "Messages without an ESC code", stats.invalid_packets);
+    write_counter(out, prefix, "invalid_headers_total", "Messages with a truncated header", stats.invalid_headers);
+    write_counter(out, prefix, "invalid_bodies_total", "Messages with an invalid body", stats.invalid_bodies);
+    write_counter(out, prefix, "checksum_failures_total", "Messages with a bad checksum", stats.checksum_failures);
+    write_counter(out, prefix, "terminal_failures_total", "Messages with a bad terminal code", stats.terminal_failures);
+    write_counter(out, prefix, "duplicates_total", "Copies dropped by line arbitration", stats.duplicates);
+    write_counter(out, prefix, "ring_drops_total", "Packets dropped by the dispatch ring", stats.ring_drops);
+    write_summary(out, prefix, "receive_to_callback", "Receive timestamp to callback entry",
+                  stats.receive_to_callback);
+    write_summary(out, prefix, "callback_duration", "Time spent in the callback", stats.callback_duration);
+    return out.str();
+}
+
+StatsExporter::~StatsExporter() {
+    stop();
+}
+
+bool StatsExporter::start(const Source& source, const std::string& file_path, int http_port, int interval_ms) {
+    stop();
+
+    this->source = source;
+    this->file_path = file_path;
+    this->interval_ms = interval_ms > 0 ? interval_ms : 1000;
+
+    if (http_port > 0) {
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (listen_fd < 0) return false;
+
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        // Local scrapes only
+        struct sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(http_port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 8) < 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+    }
+
+    running = true;
+    thread = std::thread(&StatsExporter::export_loop, this);
+    return true;
+}
+
+void StatsExporter::stop() {
+    if (!running) return;
+    running = false;
+    thread.join();
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+}
+
+void StatsExporter::export_loop() {
+    auto next_write = std::chrono::steady_clock::now();
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        if (!file_path.empty() && now >= next_write) {
+            write_file(format_prometheus(source()));
+            next_write = now + std::chrono::milliseconds(interval_ms);
+        }
+
+        // Wait for a scrape, but wake up often enough to notice stop()
+        struct pollfd pfd{};
+        pfd.fd = listen_fd;
+        pfd.events = POLLIN;
+        int ready = poll(listen_fd >= 0 ? &pfd : nullptr, listen_fd >= 0 ? 1 : 0, 100);
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            int client = accept(listen_fd, nullptr, nullptr);
+            if (client >= 0) {
+                serve_client(client, format_prometheus(source()));
+                close(client);
+            }
+        }
+    }
+
+    // Leave the final values behind
+    if (!file_path.empty()) write_file(format_prometheus(source()));
+}
+
+void StatsExporter::write_file(const std::string& text) {
+    std::string temporary = file_path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "w");
+    if (file == nullptr) return;
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = fclose(file) == 0 && ok;
+    if (ok) rename(temporary.c_str(), file_path.c_str());
+}
+
+void StatsExporter::serve_client(int client, const std::string& text) {
+    // Read (and ignore) the request; every path returns the metrics
+    struct pollfd pfd{};
+    pfd.fd = client;
+    pfd.events = POLLIN;
+    char request[1024];
+    if (poll(&pfd, 1, 200) > 0) {
+        ssize_t ignored = recv(client, request, sizeof(request), 0);
+        (void)ignored;
+    }
+
+    std::string response = "HTTP/1.0 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(text.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + text;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
@@ -0,0 +1,238 @@
+#include "warrant_index.h"
+#include "parser.h"
+#include "symbol.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+// Both key tables stay at most half full, since there are never more underlyings than warrants
+size_t table_size(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity * 2) rounded <<= 1;
+    return rounded;
+}
+
+} // namespace
+
+WarrantIndex::WarrantIndex(size_t capacity) : entry_capacity(capacity == 0 ? 1 : capacity) {
+    owned.reset(new uint8_t[memory_size(entry_capacity)]);
+    place(owned.get(), false);
+}
+
+WarrantIndex::WarrantIndex(size_t capacity, void* memory, bool attach)
+    : entry_capacity(capacity == 0 ? 1 : capacity) {
+    place(memory, attach);
+}
+
+size_t WarrantIndex::memory_size(size_t capacity) {
+    if (capacity == 0) capacity = 1;
+    return capacity * sizeof(Entry) + table_size(capacity) * (sizeof(CodeSlot) + sizeof(UnderlyingSlot));
+}
+
+void WarrantIndex::place(void* memory, bool attach) {
+    size_t rounded = table_size(entry_capacity);
+    uint8_t* position = static_cast<uint8_t*>(memory);
+    entries = reinterpret_cast<Entry*>(position);
+    position += entry_capacity * sizeof(Entry);
+    codes = reinterpret_cast<CodeSlot*>(position);
+    position += rounded * sizeof(CodeSlot);
+    underlyings = reinterpret_cast<UnderlyingSlot*>(position);
+    code_mask = rounded - 1;
+    underlying_mask = rounded - 1;
+
+    if (!attach) {
+        for (size_t i = 0; i < entry_capacity; ++i) {
+            new (&entries[i]) Entry;
+            std::memset(&entries[i].info, 0, sizeof(WarrantInfo));
+        }
+        for (size_t i = 0; i < rounded; ++i) {
+            new (&codes[i]) CodeSlot;
+            new (&underlyings[i]) UnderlyingSlot;
+        }
+        return;
+    }
+
+    // Reattach: rebuild the counters and list tails, and release any entry a
+    // writer that died mid-update left with an odd sequence
+    for (size_t i = 0; i < entry_capacity; ++i) {
+        uint32_t sequence = entries[i].sequence.load(std::memory_order_relaxed);
+        if (sequence & 1) entries[i].sequence.store(sequence + 1, std::memory_order_relaxed);
+    }
+    size_t used = 0;
+    for (size_t i = 0; i < rounded; ++i) {
+        if (codes[i].key.load(std::memory_order_relaxed) != 0 && codes[i].id < entry_capacity &&
+            codes[i].id + 1 > used) {
+            used = codes[i].id + 1;
+        }
+    }
+    count.store(used, std::memory_order_relaxed);
+
+    size_t interned = 0;
+    for (size_t i = 0; i < rounded; ++i) {
+        UnderlyingSlot& slot = underlyings[i];
+        if (slot.low.load(std::memory_order_relaxed) == 0) continue;
+        interned++;
+        slot.tail = NONE;
+        uint32_t id = slot.head.load(std::memory_order_relaxed);
+        for (size_t steps = 0; id != NONE && id < entry_capacity && steps < entry_capacity; ++steps) {
+            slot.tail = id;
+            id = entries[id].next.load(std::memory_order_relaxed);
+        }
+    }
+    underlyings_used.store(interned, std::memory_order_relaxed);
+}
+
+void WarrantIndex::underlying_key(const char* text, size_t length, uint64_t& low, uint64_t& high) {
+    char padded[16];
+    std::memset(padded, ' ', sizeof(padded));
+    std::memcpy(padded, text, length < sizeof(padded) ? length : sizeof(padded));
+    // The feed pads with spaces or NULs; both name the same underlying
+    for (char& c : padded) {
+        if (c == '\0') c = ' ';
+    }
+    std::memcpy(&low, padded, 8);
+    std::memcpy(&high, padded + 8, 8);
+}
+
+uint32_t WarrantIndex::find_code(uint64_t key) const {
+    for (size_t i = 0, index = hash_stock_key(key) & code_mask; i <= code_mask; ++i, index = (index + 1) & code_mask) {
+        uint64_t current = codes[index].key.load(std::memory_order_acquire);
+        if (current == key) return codes[index].id;
+        if (current == 0) return NONE;
+    }
+    return NONE;
+}
+
+const WarrantIndex::UnderlyingSlot* WarrantIndex::find_underlying(uint64_t low, uint64_t high) const {
+    for (size_t i = 0, index = hash_stock_key(low ^ high) & underlying_mask; i <= underlying_mask;
+         ++i, index = (index + 1) & underlying_mask) {
+        const UnderlyingSlot& slot = underlyings[index];
+        uint64_t current = slot.low.load(std::memory_order_acquire);
+        if (current == 0) return nullptr;
+        if (current == low && slot.high == high) return &slot;
+    }
+    return nullptr;
+}
+
+WarrantIndex::UnderlyingSlot* WarrantIndex::claim_underlying(uint64_t low, uint64_t high) {
+    for (size_t i = 0, index = hash_stock_key(low ^ high) & underlying_mask; i <= underlying_mask;
+         ++i, index = (index + 1) & underlying_mask) {
+        UnderlyingSlot& slot = underlyings[index];
+        uint64_t current = slot.low.load(std::memory_order_relaxed);
+        if (current == low && slot.high == high) return &slot;
+        if (current == 0) {
+            // Publish the first word last so readers never match a half-written key
+            slot.high = high;
+            slot.id = static_cast<uint32_t>(underlyings_used.load(std::memory_order_relaxed));
+            slot.low.store(low, std::memory_order_release);
+            underlyings_used.fetch_add(1, std::memory_order_relaxed);
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+bool WarrantIndex::update(const Packet& packet) {
+    uint64_t key = pack_stock_code(packet.stock_code);
+    uint32_t id = find_code(key);
+    bool added = id == NONE;
+
+    UnderlyingSlot* underlying = nullptr;
+    if (added) {
+        size_t used = count.load(std::memory_order_relaxed);
+        if (used == entry_capacity) return false;
+        uint64_t low, high;
+        underlying_key(packet.underlying_asset, sizeof(packet.underlying_asset), low, high);
+        underlying = claim_underlying(low, high);
+        if (underlying == nullptr) return false;
+        id = static_cast<uint32_t>(used);
+    }
+
+    Entry& entry = entries[id];
+    uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    WarrantInfo& info = entry.info;
+    if (added) {
+        std::memcpy(info.warrant_code, packet.stock_code, 6);
+        std::memcpy(info.underlying_asset, packet.underlying_asset, 16);
+        info.id = id;
+        info.underlying_id = underlying->id;
+    }
+    info.business_type = packet.business_type;
+    std::memcpy(info.brief_name, packet.warrant_brief_name, 16);
+    std::memcpy(info.expiration_date, packet.expiration_date, 8);
+    std::memcpy(info.warrant_type_D, packet.warrant_type_D, 2);
+    std::memcpy(info.warrant_type_E, packet.warrant_type_E, 2);
+    std::memcpy(info.warrant_type_F, packet.warrant_type_F, 2);
+    info.update_count++;
+
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+
+    if (added) {
+        // Make the new entry reachable by code, then by underlying, then by id
+        for (size_t index = hash_stock_key(key) & code_mask;; index = (index + 1) & code_mask) {
+            if (codes[index].key.load(std::memory_order_relaxed) == 0) {
+                codes[index].id = id;
+                codes[index].key.store(key, std::memory_order_release);
+                break;
+            }
+        }
+        if (underlying->tail == NONE) {
+            underlying->head.store(id, std::memory_order_release);
+        } else {
+            entries[underlying->tail].next.store(id, std::memory_order_release);
+        }
+        underlying->tail = id;
+        count.store(id + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+bool WarrantIndex::lookup(const char* warrant_code, WarrantInfo& out) const {
+    return get(find_code(pack_stock_code(warrant_code)), out);
+}
+
+bool WarrantIndex::lookup(const std::string& warrant_code, WarrantInfo& out) const {
+    return get(find_code(pack_stock_code(warrant_code)), out);
+}
+
+bool WarrantIndex::get(uint32_t id, WarrantInfo& out) const {
+    if (id == NONE || id >= entry_capacity) return false;
+    const Entry& entry = entries[id];
+    while (true) {
+        uint32_t before = entry.sequence.load(std::memory_order_acquire);
+        if (before == 0) return false; // Never written
+        if (before & 1) continue;      // Writer in progress
+        std::memcpy(&out, &entry.info, sizeof(WarrantInfo));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+}
+
+uint32_t WarrantIndex::first_on(const char* stock_code) const {
+    uint64_t low, high;
+    underlying_key(stock_code, 6, low, high);
+    const UnderlyingSlot* slot = find_underlying(low, high);
+    return slot == nullptr ? NONE : slot->head.load(std::memory_order_acquire);
+}
+
+uint32_t WarrantIndex::next_on(uint32_t id) const {
+    return entries[id].next.load(std::memory_order_acquire);
+}
+
+std::vector<WarrantInfo> WarrantIndex::warrants_on(const std::string& underlying) const {
+    uint64_t low, high;
+    underlying_key(underlying.data(), underlying.size(), low, high);
+    std::vector<WarrantInfo> result;
+    const UnderlyingSlot* slot = find_underlying(low, high);
+    if (slot == nullptr) return result;
+
+    WarrantInfo info;
+    for (uint32_t id = slot->head.load(std::memory_order_acquire); id != NONE; id = next_on(id)) {
+        if (get(id, info)) result.push_back(info);
+    }
+    return result;
+}
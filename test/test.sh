@@ -9,11 +9,13 @@ SESSION_NAME="twse-udp-resolver-testing"
 # Start a tmux session
 tmux new-session -d -s $SESSION_NAME
 
-# Start the parser container
+# Start the container with the feed simulator; set SIMULATOR_ARGS for a load test,
+# e.g. SIMULATOR_ARGS="-rate 0 -duration 30" for line rate
+SIMULATOR_ARGS=${SIMULATOR_ARGS:-"-rate 10 -symbols 20"}
 tmux send-keys -t $SESSION_NAME \
-    "docker run --rm --name=testing-container twse-udp-resolver-img python3 test/TWSE_mocker.py" C-m
+    "docker run --rm --name=testing-container twse-udp-resolver-img ./build/twse_feed_simulator $SIMULATOR_ARGS" C-m
 
-# Create a new pane and start the mocker container
+# Create a new pane and start the parser in the same container
 tmux split-window -h -t $SESSION_NAME
 tmux send-keys -t $SESSION_NAME \
     "docker exec -it testing-container ./build/twse_udp_resolver_cpp_interface" C-m
@@ -0,0 +1,172 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../include/arbiter.h"
+
+// Checks for LineArbiter: duplicates, late fills, gap reporting and resets
+
+static int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": " #condition << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+constexpr uint8_t FEED = 0;
+constexpr uint8_t FORMAT = 0x06;
+
+struct Fixture {
+    LineArbiter arbiter;
+    std::vector<GapEvent> gaps;
+
+    Fixture() {
+        arbiter.set_gap_callback([this](const GapEvent& event) { gaps.push_back(event); });
+    }
+
+    bool accept(uint32_t sequence) { return arbiter.accept(FEED, FORMAT, sequence); }
+    ArbitrationStats stats() const { return arbiter.stats(FEED); }
+};
+
+// Both lines deliver every number: each one passes once
+static void test_duplicates() {
+    Fixture f;
+    for (uint32_t sequence = 1; sequence <= 100; ++sequence) {
+        CHECK(f.accept(sequence));
+        CHECK(!f.accept(sequence));
+    }
+    CHECK(f.stats().delivered == 100);
+    CHECK(f.stats().duplicates == 100);
+    CHECK(f.gaps.empty());
+}
+
+// Line A skips a number and line B supplies it later: no gap
+static void test_late_fill() {
+    Fixture f;
+    CHECK(f.accept(1));
+    CHECK(f.accept(3));    // A skipped 2
+    CHECK(!f.accept(1));   // B catching up
+    CHECK(f.accept(2));    // B fills the hole
+    CHECK(!f.accept(3));
+    CHECK(!f.accept(2));
+    for (uint32_t sequence = 4; sequence < 4 + LineArbiter::WINDOW * 2; ++sequence) {
+        CHECK(f.accept(sequence));
+    }
+    CHECK(f.gaps.empty());
+    CHECK(f.stats().out_of_order == 1);
+    CHECK(f.stats().missing == 0);
+}
+
+// A hole neither line fills is reported once the window has moved past it
+static void test_gap() {
+    Fixture f;
+    CHECK(f.accept(10));
+    CHECK(f.accept(15)); // 11..14 missing on both lines
+    CHECK(f.gaps.empty());
+
+    uint32_t sequence = 16;
+    while (f.gaps.empty() && sequence < 16 + LineArbiter::WINDOW * 2) {
+        CHECK(f.accept(sequence++));
+    }
+    CHECK(f.gaps.size() == 1);
+    if (!f.gaps.empty()) {
+        CHECK(f.gaps[0].feed_id == FEED);
+        CHECK(f.gaps[0].format_code == FORMAT);
+        CHECK(f.gaps[0].first_missing == 11);
+        CHECK(f.gaps[0].last_missing == 14);
+    }
+    // Reported once the window moved past the whole run, not number by number
+    CHECK(sequence - 1 == 15 + LineArbiter::WINDOW);
+    CHECK(f.stats().gaps == 1);
+    CHECK(f.stats().missing == 4);
+}
+
+// A jump further ahead than the window: the part still inside it can be filled
+static void test_large_gap() {
+    Fixture f;
+    const uint32_t window = LineArbiter::WINDOW;
+    CHECK(f.accept(1));
+    CHECK(f.accept(2 + window * 3));
+    CHECK(f.accept(1 + window * 3));
+    CHECK(!f.accept(1 + window * 3));
+    for (uint32_t sequence = 3 + window * 3; sequence <= 1 + window * 4; ++sequence) {
+        CHECK(f.accept(sequence));
+    }
+    CHECK(f.gaps.size() == 1);
+    if (!f.gaps.empty()) {
+        CHECK(f.gaps[0].first_missing == 2);
+        CHECK(f.gaps[0].last_missing == window * 3);
+    }
+}
+
+// A new session, a feed reset or a wrap restarts the stream instead of dropping it
+static void test_reset() {
+    Fixture f;
+    for (uint32_t sequence = 50000; sequence < 50010; ++sequence) CHECK(f.accept(sequence));
+    CHECK(f.accept(1));
+    CHECK(f.stats().resets == 1);
+    for (uint32_t sequence = 2; sequence < 100; ++sequence) {
+        CHECK(f.accept(sequence));
+        CHECK(!f.accept(sequence));
+    }
+    // Nothing of the old session was missing
+    CHECK(f.gaps.empty());
+
+    // Wrap of an eight-digit counter
+    Fixture w;
+    CHECK(w.accept(99999998));
+    CHECK(w.accept(99999999));
+    CHECK(w.accept(0));
+    CHECK(w.accept(1));
+    CHECK(!w.accept(0));
+    CHECK(w.stats().resets == 1);
+    CHECK(w.stats().delivered == 4);
+
+    // One bogus high number does not blackhole the stream
+    Fixture b;
+    for (uint32_t sequence = 1; sequence <= 10; ++sequence) CHECK(b.accept(sequence));
+    CHECK(b.accept(90000000));
+    for (uint32_t sequence = 11; sequence <= 20; ++sequence) CHECK(b.accept(sequence));
+    CHECK(b.stats().resets == 1);
+}
+
+// Numbers just before the first one seen are delivered once, not dropped as stale
+static void test_before_first() {
+    Fixture f;
+    CHECK(f.accept(100));
+    CHECK(f.accept(99));
+    CHECK(!f.accept(99));
+    CHECK(!f.accept(100));
+    CHECK(f.stats().delivered == 2);
+}
+
+// Streams are independent per feed and format code
+static void test_streams() {
+    LineArbiter arbiter;
+    CHECK(arbiter.accept(0, 0x06, 1));
+    CHECK(arbiter.accept(0, 0x17, 1));
+    CHECK(arbiter.accept(1, 0x06, 1));
+    CHECK(!arbiter.accept(0, 0x06, 1));
+    arbiter.reset();
+    CHECK(arbiter.accept(0, 0x06, 1));
+    CHECK(arbiter.stats(0).delivered == 1);
+}
+
+int main() {
+    test_duplicates();
+    test_late_fill();
+    test_gap();
+    test_large_gap();
+    test_reset();
+    test_before_first();
+    test_streams();
+
+    if (failures != 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "arbiter: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../include/parser.h"
+#include "../include/framing.h"
+
+// Checks for message framing and the vectorised terminal-code search and checksum
+
+static int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": " #condition << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static size_t find_terminal_code_reference(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i + 1 < length; ++i) {
+        if (data[i] == 0x0D && data[i + 1] == 0x0A) return i;
+    }
+    return length;
+}
+
+static uint8_t xor_reference(const uint8_t* data, size_t length) {
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < length; ++i) checksum ^= data[i];
+    return checksum;
+}
+
+static uint8_t bcd_byte(unsigned value) {
+    return static_cast<uint8_t>((value / 10) << 4 | (value % 10));
+}
+
+// Format 6 message with one trade level; every byte after the header is taken as given
+static std::vector<uint8_t> make_message(uint32_t sequence, uint8_t limit_up_limit_down, uint8_t status_note,
+                                         const uint8_t (&price)[5]) {
+    std::vector<uint8_t> message = {0x1B, 0x00, 0x00, 0x01, 0x06, 0x04,
+                                    bcd_byte(sequence / 1000000 % 100), bcd_byte(sequence / 10000 % 100),
+                                    bcd_byte(sequence / 100 % 100), bcd_byte(sequence % 100)};
+    const uint8_t body[] = {'2', '3', '3', '0', ' ', ' ',          // stock_code
+                            0x09, 0x00, 0x00, 0x00, 0x00, 0x00,    // match_time
+                            0x80, limit_up_limit_down, status_note, // display_item: trade only
+                            0x00, 0x00, 0x12, 0x34};                // cumulative_volume
+    message.insert(message.end(), body, body + sizeof(body));
+    message.insert(message.end(), price, price + 5);
+    const uint8_t quantity[] = {0x00, 0x00, 0x00, 0x05};
+    message.insert(message.end(), quantity, quantity + 4);
+
+    size_t length = message.size() + 3;
+    message[1] = bcd_byte(static_cast<unsigned>(length / 100));
+    message[2] = bcd_byte(static_cast<unsigned>(length % 100));
+    message.push_back(xor_reference(message.data() + 1, message.size() - 1));
+    message.push_back(0x0D);
+    message.push_back(0x0A);
+    return message;
+}
+
+// Body bytes equal to 0D 0A must not split a message that message_length frames
+static void test_embedded_terminal_code() {
+    const uint8_t split_price[5] = {0x00, 0x0D, 0x0A, 0x00, 0x00};
+    const uint8_t plain_price[5] = {0x00, 0x00, 0x99, 0x50, 0x00};
+
+    std::vector<uint8_t> datagram = make_message(1, 0x0D, 0x0A, split_price);
+    std::vector<uint8_t> second = make_message(2, 0x00, 0x00, plain_price);
+    datagram.insert(datagram.end(), second.begin(), second.end());
+
+    Parser parser;
+    std::vector<Packet> packets;
+    parser.set_packet_callback([&packets](const Packet& packet) { packets.push_back(packet); });
+    parser.parse_buffer(datagram.data(), datagram.size());
+
+    CHECK(packets.size() == 2);
+    if (packets.size() == 2) {
+        CHECK(packets[0].transmission_number == 0x00000001);
+        CHECK(packets[0].limit_up_limit_down == 0x0D);
+        CHECK(packets[0].status_note == 0x0A);
+        CHECK(packets[0].level_count == 1);
+        CHECK(packets[0].prices[0] == 0x0D0A0000);
+        CHECK(packets[0].quantities[0] == 0x00000005);
+        CHECK(packets[1].transmission_number == 0x00000002);
+        CHECK(packets[1].prices[0] == 0x00995000);
+    }
+    ParserStats stats = parser.stats();
+    CHECK(stats.invalid_headers == 0);
+    CHECK(stats.invalid_bodies == 0);
+    CHECK(stats.checksum_failures == 0);
+    CHECK(stats.terminal_failures == 0);
+}
+
+// A message whose length field is wrong is skipped up to the next 0D 0A, and framing resumes after it
+static void test_resync() {
+    const uint8_t price[5] = {0x00, 0x00, 0x99, 0x50, 0x00};
+    std::vector<uint8_t> datagram = make_message(1, 0x00, 0x00, price);
+    datagram[2] = 0x99; // Longer than the datagram
+    std::vector<uint8_t> second = make_message(2, 0x00, 0x00, price);
+    datagram.insert(datagram.end(), second.begin(), second.end());
+
+    Parser parser;
+    std::vector<Packet> packets;
+    parser.set_packet_callback([&packets](const Packet& packet) { packets.push_back(packet); });
+    parser.parse_buffer(datagram.data(), datagram.size());
+
+    CHECK(packets.size() == 1);
+    if (!packets.empty()) CHECK(packets[0].transmission_number == 0x00000002);
+}
+
+// Inline batch delivery hands over the messages of one datagram in a single call
+static void test_inline_batch() {
+    const uint8_t price[5] = {0x00, 0x00, 0x99, 0x50, 0x00};
+    std::vector<uint8_t> datagram;
+    for (uint32_t sequence = 1; sequence <= 3; ++sequence) {
+        std::vector<uint8_t> message = make_message(sequence, 0x00, 0x00, price);
+        datagram.insert(datagram.end(), message.begin(), message.end());
+    }
+
+    Parser parser;
+    std::vector<size_t> calls;
+    parser.set_batch_callback(2, [&calls](const Packet*, size_t count) { calls.push_back(count); });
+    parser.parse_buffer(datagram.data(), datagram.size());
+
+    CHECK(calls.size() == 2);
+    if (calls.size() == 2) {
+        CHECK(calls[0] == 2);
+        CHECK(calls[1] == 1);
+    }
+}
+
+static void test_find_terminal_code() {
+    std::mt19937 random(1);
+    std::vector<uint8_t> buffer(512);
+    for (int round = 0; round < 20000; ++round) {
+        size_t length = random() % buffer.size();
+        // Mostly 0D and 0A, so lone halves and pairs land at every position
+        for (size_t i = 0; i < length; ++i) {
+            uint32_t draw = random() % 64;
+            buffer[i] = draw == 0 ? 0x0D : draw == 1 ? 0x0A : static_cast<uint8_t>(random());
+        }
+        size_t offset = length == 0 ? 0 : random() % (length + 1);
+        CHECK(find_terminal_code(buffer.data() + offset, length - offset) ==
+              find_terminal_code_reference(buffer.data() + offset, length - offset));
+    }
+
+    // A pair straddling each 16-byte block boundary
+    for (size_t position = 0; position + 1 < 64; ++position) {
+        std::vector<uint8_t> data(64, 0x0D);
+        data[position + 1] = 0x0A;
+        CHECK(find_terminal_code(data.data(), data.size()) == position);
+    }
+}
+
+static void test_xor_checksum() {
+    std::mt19937 random(2);
+    std::vector<uint8_t> buffer(1024);
+    for (uint8_t& byte : buffer) byte = static_cast<uint8_t>(random());
+
+    const XorKernel kernels[] = {XorKernel::Scalar, XorKernel::SSE2, XorKernel::AVX2};
+    for (XorKernel kernel : kernels) {
+        if (!has_xor_kernel(kernel)) {
+            std::cout << "xor kernel " << static_cast<int>(kernel) << " not available, skipped" << std::endl;
+            continue;
+        }
+        for (size_t offset = 0; offset < 33; ++offset) {
+            for (size_t length = 0; offset + length <= 300; ++length) {
+                CHECK(xor_checksum(kernel, buffer.data() + offset, length) ==
+                      xor_reference(buffer.data() + offset, length));
+            }
+        }
+    }
+    CHECK(xor_checksum(buffer.data(), buffer.size()) == xor_reference(buffer.data(), buffer.size()));
+}
+
+int main() {
+    test_embedded_terminal_code();
+    test_resync();
+    test_inline_batch();
+    test_find_terminal_code();
+    test_xor_checksum();
+
+    if (failures != 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "framing: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../include/parser.h"
+#include "../include/batch_decoder.h"
+
+// Decode a pcap or capture file and write one CSV row per packet to stdout
+int main(int argc, char* argv[]) {
+    std::string input;
+    BatchDecodeOptions options;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-input" && i + 1 < argc) {
+            input = argv[++i];
+        } else if (arg == "-threads" && i + 1 < argc) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (arg == "-decode-bcd") {
+            options.decode_bcd = true;
+        } else if (arg == "-no-dedupe") {
+            options.deduplicate = false;
+        } else if (arg == "-port-feed" && i + 1 < argc) {
+            // PORT:FEED, e.g. 10000:0
+            std::string mapping = argv[++i];
+            size_t colon = mapping.find(':');
+            if (colon == std::string::npos) {
+                std::cerr << "Invalid port mapping: " << mapping << std::endl;
+                return 1;
+            }
+            options.port_feeds.emplace_back(static_cast<uint16_t>(std::stoi(mapping.substr(0, colon))),
+                                            static_cast<uint8_t>(std::stoi(mapping.substr(colon + 1))));
+        } else if (arg == "-format-codes") {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                try {
+                    options.format_codes.push_back(static_cast<uint8_t>(std::stoi(argv[++i])));
+                } catch (const std::exception& e) {
+                    std::cerr << "Invalid format code: " << argv[i] << std::endl;
+                }
+            }
+        }
+    }
+
+    if (input.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " -input FILE [-threads N] [-format-codes 6 23 ...] [-port-feed PORT:FEED ...]"
+                  << " [-decode-bcd] [-no-dedupe]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "receive_timestamp_ns,feed_id,line_id,format_code,transmission_number,stock_code,"
+                 "match_time,display_item,cumulative_volume,level_count\n";
+    // Rows are written as each round of the file is decoded
+    bool ok = decode_capture_file(input, options, [](const Packet* packets, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const Packet& packet = packets[i];
+            // PACK BCD fields print as hex so the digits read as decimal
+            auto bcd = packet.bcd_decoded ? std::dec : std::hex;
+            std::cout << packet.receive_timestamp_ns << ','
+                      << static_cast<int>(packet.feed_id) << ','
+                      << static_cast<int>(packet.line_id) << ','
+                      << std::hex << static_cast<int>(packet.format_code) << ','
+                      << packet.transmission_number << std::dec << ','
+                      << std::string(packet.stock_code, 6) << ','
+                      << bcd << packet.match_time << std::dec << ','
+                      << static_cast<int>(packet.display_item) << ','
+                      << bcd << packet.cumulative_volume << std::dec << ','
+                      << static_cast<int>(packet.level_count) << '\n';
+        }
+    });
+    if (!ok) {
+        std::cerr << "Failed to open " << input << " as a pcap or capture file" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../include/feed_generator.h"
+
+// Synthetic TWSE/OTC feed sender for load tests.
+//
+// Messages come from FeedGenerator, so they decode cleanly. Datagrams go to a
+// unicast address or a multicast group (looped back to this host by default),
+// paced at a message rate or in bursts, with optional gaps (datagrams dropped
+// before sending), duplicates (a datagram sent twice) and an A/B copy on a
+// second port or group. Gaps are drawn independently per line, so a parser
+// doing A/B arbitration can fill them from the other line.
+
+namespace {
+
+constexpr size_t SEND_BATCH = 64;
+constexpr size_t DATAGRAM_CAPACITY = 1500;
+
+std::atomic<bool> running(true);
+
+void signal_handler(int) {
+    running = false;
+}
+
+struct Line {
+    int fd = -1;
+    struct sockaddr_in address{};
+    uint64_t datagrams = 0;
+    uint64_t messages = 0;
+    uint64_t gaps = 0;
+    uint64_t duplicates = 0;
+};
+
+// Datagrams queued for one sendmmsg() call per line
+struct SendBatch {
+    uint8_t data[SEND_BATCH][DATAGRAM_CAPACITY];
+    struct iovec iovecs[SEND_BATCH];
+    struct mmsghdr messages[SEND_BATCH];
+    size_t count = 0;
+};
+
+bool open_line(Line& line, const std::string& host, int port, const std::string& interface_ip, int ttl) {
+    line.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (line.fd < 0) {
+        std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    line.address.sin_family = AF_INET;
+    line.address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &line.address.sin_addr) != 1) {
+        std::cerr << "Invalid address: " << host << std::endl;
+        return false;
+    }
+
+    // Large enough for a full send batch at line rate
+    int buffer_size = 4 * 1024 * 1024;
+    setsockopt(line.fd, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+
+    if (IN_MULTICAST(ntohl(line.address.sin_addr.s_addr))) {
+        struct in_addr local_interface{};
+        local_interface.s_addr = inet_addr(interface_ip.c_str());
+        unsigned char loop = 1;
+        unsigned char hops = static_cast<unsigned char>(ttl);
+        if (setsockopt(line.fd, IPPROTO_IP, IP_MULTICAST_IF, &local_interface, sizeof(local_interface)) < 0 ||
+            setsockopt(line.fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0 ||
+            setsockopt(line.fd, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops)) < 0) {
+            std::cerr << "Failed to configure multicast: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void flush(Line& line, SendBatch& batch) {
+    size_t sent = 0;
+    while (sent < batch.count) {
+        int result = sendmmsg(line.fd, batch.messages + sent, static_cast<unsigned>(batch.count - sent), 0);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS || errno == EAGAIN) {
+                // The local queue is full at line rate; wait for it to drain
+                std::this_thread::yield();
+                continue;
+            }
+            std::cerr << "Failed to send: " << strerror(errno) << std::endl;
+            break;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    batch.count = 0;
+}
+
+void queue(Line& line, SendBatch& batch, const uint8_t* data, size_t length) {
+    size_t slot = batch.count++;
+    std::memcpy(batch.data[slot], data, length);
+    batch.iovecs[slot].iov_base = batch.data[slot];
+    batch.iovecs[slot].iov_len = length;
+    std::memset(&batch.messages[slot], 0, sizeof(batch.messages[slot]));
+    batch.messages[slot].msg_hdr.msg_name = &line.address;
+    batch.messages[slot].msg_hdr.msg_namelen = sizeof(line.address);
+    batch.messages[slot].msg_hdr.msg_iov = &batch.iovecs[slot];
+    batch.messages[slot].msg_hdr.msg_iovlen = 1;
+    if (batch.count == SEND_BATCH) flush(line, batch);
+}
+
+// Probability draws for gaps and duplicates, independent of the generator's stream
+struct Dice {
+    uint64_t state;
+    double roll() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<double>((state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+    }
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    FeedGeneratorOptions options;
+    std::string host = "127.0.0.1";
+    std::string host_b;
+    std::string interface_ip = "127.0.0.1";
+    int port = 10000;
+    int port_b = 0;
+    int ttl = 0;
+    double rate = 10000;          // Messages per second, 0 for as fast as possible
+    size_t burst = 0;             // Datagrams per burst, 0 to pace evenly
+    double burst_interval_ms = 100;
+    double duration = 0;          // Seconds, 0 to run until interrupted
+    uint64_t max_messages = 0;
+    double gap_rate = 0;
+    double duplicate_rate = 0;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-host" || arg == "-group") && i + 1 < argc) {
+            host = argv[++i];
+        } else if (arg == "-port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "-iface" && i + 1 < argc) {
+            interface_ip = argv[++i];
+        } else if (arg == "-ttl" && i + 1 < argc) {
+            ttl = std::stoi(argv[++i]);
+        } else if (arg == "-ab") {
+            if (port_b == 0) port_b = -1;
+        } else if ((arg == "-host-b" || arg == "-group-b") && i + 1 < argc) {
+            host_b = argv[++i];
+        } else if (arg == "-port-b" && i + 1 < argc) {
+            port_b = std::stoi(argv[++i]);
+        } else if (arg == "-rate" && i + 1 < argc) {
+            rate = std::stod(argv[++i]);
+        } else if (arg == "-burst" && i + 1 < argc) {
+            burst = std::stoul(argv[++i]);
+        } else if (arg == "-burst-interval" && i + 1 < argc) {
+            burst_interval_ms = std::stod(argv[++i]);
+        } else if (arg == "-duration" && i + 1 < argc) {
+            duration = std::stod(argv[++i]);
+        } else if (arg == "-count" && i + 1 < argc) {
+            max_messages = std::stoull(argv[++i]);
+        } else if (arg == "-symbols" && i + 1 < argc) {
+            options.symbols = std::stoul(argv[++i]);
+        } else if (arg == "-warrants" && i + 1 < argc) {
+            options.warrants = std::stoul(argv[++i]);
+        } else if (arg == "-per-datagram" && i + 1 < argc) {
+            options.max_messages_per_datagram = std::stoul(argv[++i]);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "-gap-rate" && i + 1 < argc) {
+            gap_rate = std::stod(argv[++i]);
+        } else if (arg == "-dup-rate" && i + 1 < argc) {
+            duplicate_rate = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [-host ADDR | -group GROUP] [-port PORT] [-iface IP] [-ttl N]\n"
+                      << "  [-ab] [-host-b ADDR | -group-b GROUP] [-port-b PORT]\n"
+                      << "  [-rate MSGS_PER_SEC] [-burst DATAGRAMS] [-burst-interval MS]\n"
+                      << "  [-duration SECONDS] [-count MESSAGES]\n"
+                      << "  [-symbols N] [-warrants N] [-per-datagram N] [-seed N]\n"
+                      << "  [-gap-rate P] [-dup-rate P]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Line> lines(1);
+    if (!open_line(lines[0], host, port, interface_ip, ttl)) return 1;
+    if (port_b != 0 || !host_b.empty()) {
+        // Line B defaults to the same address on the next port
+        lines.emplace_back();
+        if (!open_line(lines[1], host_b.empty() ? host : host_b, port_b > 0 ? port_b : port + 1, interface_ip, ttl)) {
+            return 1;
+        }
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    FeedGenerator generator(options);
+    Dice dice{options.seed * 0xD1B54A32D192ED03ULL + 7};
+    std::vector<SendBatch> batches(lines.size());
+    uint8_t datagram[DATAGRAM_CAPACITY];
+    uint8_t previous[DATAGRAM_CAPACITY];
+    size_t previous_length = 0;
+    size_t previous_messages = 0;
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+    auto next_burst = start;
+    size_t burst_sent = 0;
+    uint64_t generated = 0;
+    uint64_t checks = 0;
+
+    while (running) {
+        if (max_messages != 0 && generated >= max_messages) break;
+        // Reading the clock every datagram would cap the rate; 64 datagrams is well under 100us
+        if (duration > 0 && (checks++ & 63) == 0 && Clock::now() >= end) break;
+
+        size_t messages = 0;
+        size_t length = generator.next_datagram(datagram, sizeof(datagram), &messages);
+
+        // Pace: either one burst per interval, or evenly at the message rate
+        Clock::time_point due;
+        if (burst > 0) {
+            if (burst_sent == burst) {
+                next_burst += std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::milli>(burst_interval_ms));
+                burst_sent = 0;
+            }
+            burst_sent++;
+            due = next_burst;
+        } else if (rate > 0) {
+            due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(generated / rate));
+        } else {
+            due = start;
+        }
+        generated += messages;
+
+        if (due > Clock::now()) {
+            // Send what is queued before waiting, so nothing sits in the batch
+            for (size_t l = 0; l < lines.size(); ++l) flush(lines[l], batches[l]);
+            if (due - Clock::now() > std::chrono::microseconds(200)) {
+                std::this_thread::sleep_until(due - std::chrono::microseconds(100));
+            }
+            while (Clock::now() < due) {}
+        }
+
+        bool duplicate = previous_length > 0 && duplicate_rate > 0 && dice.roll() < duplicate_rate;
+        for (size_t l = 0; l < lines.size(); ++l) {
+            Line& line = lines[l];
+            if (gap_rate > 0 && dice.roll() < gap_rate) {
+                line.gaps += messages;
+            } else {
+                queue(line, batches[l], datagram, length);
+                line.datagrams++;
+                line.messages += messages;
+            }
+            if (duplicate) {
+                queue(line, batches[l], previous, previous_length);
+                line.datagrams++;
+                line.duplicates += previous_messages;
+            }
+        }
+
+        std::memcpy(previous, datagram, length);
+        previous_length = length;
+        previous_messages = messages;
+    }
+
+    for (size_t l = 0; l < lines.size(); ++l) {
+        flush(lines[l], batches[l]);
+        close(lines[l].fd);
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Generated " << generated << " messages in " << elapsed << " s ("
+              << static_cast<uint64_t>(elapsed > 0 ? generated / elapsed : 0) << " msgs/s)" << std::endl;
+    for (size_t l = 0; l < lines.size(); ++l) {
+        std::cout << "Line " << static_cast<char>('A' + l) << ": " << lines[l].datagrams << " datagrams, "
+                  << lines[l].messages << " messages, " << lines[l].gaps << " messages dropped as gaps, "
+                  << lines[l].duplicates << " messages duplicated" << std::endl;
+    }
+    return 0;
+}